@@ -0,0 +1,240 @@
+#pragma once
+
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <numeric>
+
+#include <gmpxx.h>
+
+#include "Exponent.h"
+
+// Arithmetic functions of a positive integer evaluated from its prime factorization 'primeFactors',
+// which may be any sequence of PrimePower in increasing order of primes, such as a std::vector
+// or a PrimeFactorsBuffer.
+
+// Returns the number of factors.
+template<typename PrimeFactors>
+std::size_t FactorsCount (const PrimeFactors& primeFactors)
+{
+    // Standard product form of divisor counting function.
+    std::size_t count = 1;
+
+    for (const auto& primePower : primeFactors)
+        count *= primePower.power + 1;
+
+    return count;
+}
+
+// Returns the number of prime factors with multiplicity.
+template<typename PrimeFactors>
+std::size_t BigOmega (const PrimeFactors& primeFactors)
+{
+    std::size_t sum = 0;
+
+    for (const auto& primePower : primeFactors)
+        sum += primePower.power;
+
+    return sum;
+}
+
+// Returns the 'prime'-adic valuation.
+template<std::unsigned_integral T, typename PrimeFactors>
+std::uint32_t PAdicValuation (const PrimeFactors& primeFactors, T prime)
+{
+    for (const auto& primePower : primeFactors)
+        if (primePower.prime == prime)
+            return primePower.power;
+
+    return 0;
+}
+
+// Returns the sum of the 'k'-th powers of the factors, modulo 2^64.
+template<typename PrimeFactors>
+std::uint64_t SigmaK (const PrimeFactors& primeFactors, std::uint64_t k)
+{
+    // Standard product form of divisor sum function: each prime power 'prime'^'power' contributes
+    // 1 + 'prime'^'k' + 'prime'^(2 * 'k') + ... + 'prime'^('power' * 'k').
+    std::uint64_t sigma = 1;
+
+    for (const auto& primePower : primeFactors)
+    {
+        std::uint64_t primeToK = IntegerPow (primePower.prime, k);
+        std::uint64_t term = 1;
+        std::uint64_t sum = 1;
+
+        for (std::uint32_t i = 0; i < primePower.power; ++i)
+        {
+            term *= primeToK;
+            sum += term;
+        }
+
+        sigma *= sum;
+    }
+
+    return sigma;
+}
+
+// Computes the sum of the 'k'-th powers of the factors into 'sigma' and returns true if it fits in an
+// 'unsigned __int128', or returns false leaving 'sigma' unspecified otherwise.
+template<typename PrimeFactors>
+bool TrySigmaK (const PrimeFactors& primeFactors, std::uint64_t k, unsigned __int128& sigma)
+{
+    // Standard product form of divisor sum function, checking every step for overflow.
+    sigma = 1;
+
+    for (const auto& primePower : primeFactors)
+    {
+        unsigned __int128 primeToK;
+
+        if (!CheckedIntegerPow (primePower.prime, k, primeToK))
+            return false;
+
+        unsigned __int128 term = 1;
+        unsigned __int128 sum = 1;
+
+        for (std::uint32_t i = 0; i < primePower.power; ++i)
+            if (__builtin_mul_overflow (term, primeToK, &term) || __builtin_add_overflow (sum, term, &sum))
+                return false;
+
+        if (__builtin_mul_overflow (sigma, sum, &sigma))
+            return false;
+    }
+
+    return true;
+}
+
+// Returns the sum of the 'k'-th powers of the factors exactly.
+// The sum is computed in 128-bit arithmetic, falling back to arbitrary precision only if that overflows.
+template<typename PrimeFactors>
+mpz_class ExactSigmaK (const PrimeFactors& primeFactors, std::uint64_t k)
+{
+    unsigned __int128 sigma128;
+
+    if (TrySigmaK (primeFactors, k, sigma128))
+    {
+        mpz_class sigma = std::uint64_t (sigma128 >> 64);
+        sigma <<= 64;
+        sigma += std::uint64_t (sigma128);
+        return sigma;
+    }
+
+    // Each prime power 'prime'^'power' contributes ('prime'^('k' * ('power' + 1)) - 1) / ('prime'^'k' - 1),
+    // or 'power' + 1 if 'k' is 0.
+    mpz_class sigma = 1;
+
+    for (const auto& primePower : primeFactors)
+    {
+        if (k == 0)
+        {
+            sigma *= primePower.power + 1;
+            continue;
+        }
+
+        mpz_class prime = std::uint64_t (primePower.prime);
+        mpz_class primeToK;
+        mpz_class primeToKPower;
+        mpz_pow_ui (primeToK.get_mpz_t (), prime.get_mpz_t (), k);
+        mpz_pow_ui (primeToKPower.get_mpz_t (), primeToK.get_mpz_t (), primePower.power + 1);
+        sigma *= (primeToKPower - 1) / (primeToK - 1);
+    }
+
+    return sigma;
+}
+
+// Returns the number of integers in [0, 'n') coprime to 'n'.
+template<std::unsigned_integral T, typename PrimeFactors>
+T Totient (T n, const PrimeFactors& primeFactors)
+{
+    // Standard product representation of totient function.
+    T totient = n;
+
+    for (const auto& primePower : primeFactors)
+        totient = (totient / primePower.prime) * (primePower.prime - 1);
+
+    return totient;
+}
+
+// Returns the radical, the product of the distinct prime factors.
+template<std::unsigned_integral T, typename PrimeFactors>
+T Radical (const PrimeFactors& primeFactors)
+{
+    T radical = 1;
+
+    for (const auto& primePower : primeFactors)
+        radical *= primePower.prime;
+
+    return radical;
+}
+
+// Returns 0 if the integer is not squarefree, 1 if it has an even number of prime factors, and -1 otherwise.
+template<typename PrimeFactors>
+std::int32_t MoebiusFunction (const PrimeFactors& primeFactors)
+{
+    for (const auto& primePower : primeFactors)
+        if (primePower.power > 1)
+            return 0;
+
+    // Efficient (-1)^n algorithm.
+    return (-(primeFactors.size () & 1)) | 1;
+}
+
+// Returns -1 to the power of the number of prime factors with multiplicity.
+template<typename PrimeFactors>
+std::int32_t LiouvilleFunction (const PrimeFactors& primeFactors)
+{
+    // Efficient (-1)^n algorithm.
+    return (-(BigOmega (primeFactors) & 1)) | 1;
+}
+
+// Returns the least common multiple of the multiplicative orders of the integers in [0, 'n') coprime to 'n'.
+template<std::unsigned_integral T, typename PrimeFactors>
+T CarmichaelFunction (T n, const PrimeFactors& primeFactors)
+{
+    // Standard product representation of Carmichael function.
+    if (n == 1)
+        return 1;
+
+    T exponent;
+
+    if (primeFactors[0].prime == 2)
+    {
+        if (primeFactors[0].power == 1)
+            exponent = 1;
+        else if (primeFactors[0].power == 2)
+            exponent = 2;
+        else
+            exponent = IntegerPow (2, primeFactors[0].power - 2);
+
+        for (auto primePower = primeFactors.begin () + 1; primePower != primeFactors.end (); ++primePower)
+            exponent = std::lcm
+            (
+                exponent,
+                IntegerPow (primePower->prime, primePower->power - 1) * (primePower->prime - 1)
+            );
+    }
+    else
+    {
+        exponent = 1;
+
+        for (const auto& primePower : primeFactors)
+            exponent = std::lcm
+            (
+                exponent,
+                IntegerPow (primePower.prime, primePower.power - 1) * (primePower.prime - 1)
+            );
+    }
+
+    return exponent;
+}
+
+// Returns whether no 'h'-th power divides the integer.
+template<typename PrimeFactors>
+bool IsHFree (const PrimeFactors& primeFactors, std::uint32_t h)
+{
+    for (const auto& primePower : primeFactors)
+        if (primePower.power >= h)
+            return false;
+
+    return true;
+}
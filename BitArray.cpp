@@ -1,31 +1,39 @@
 #include "BitArray.h"
 
+#include <algorithm>
+#include <bit>
 #include <cstddef>
 #include <cstdint>
 #include <vector>
 
+#if defined (__AVX2__) || defined (__SSE2__)
+#include <immintrin.h>
+#endif
+
 /*
-* Bits are stored in blocks of 32 (supposedly offering best performance), each block implemented as a 'uint32_t'.
-* Bits can be set, reset, or retrieved within a given 'uint32_t' via bitmask methods.
+* Bits are stored in blocks of 64, each block implemented as a 'uint64_t',
+* so that counting and scanning can proceed a whole block at a time with hardware popcount and ctz.
+* Bits can be set, reset, or retrieved within a given 'uint64_t' via bitmask methods.
+* Any bits in the last block beyond 'count' are ignored.
 */
 
 BitArray::BitArray (std::size_t count, bool defaultValue)
     : count (count)
 {
-    std::size_t storageCount = (count + 31) / 32;
+    std::size_t storageCount = (count + 63) / 64;
     // All 0's if false or all 1's if true.
-    std::uint32_t defaultIntValue = 0xFFFFFFFF * std::uint32_t (defaultValue);
-    storage = std::vector<std::uint32_t> (storageCount, defaultIntValue);
+    std::uint64_t defaultIntValue = ~std::uint64_t (0) * std::uint64_t (defaultValue);
+    storage = std::vector<std::uint64_t> (storageCount, defaultIntValue);
 }
 
 bool BitArray::Get (std::size_t index) const
 {
     // The index in 'storage' in which the desired bit lies.
-    std::size_t storageIndex = index / 32;
+    std::size_t storageIndex = index / 64;
     // The offset in 'storage[storageIndex]' at which the desired bit lies.
-    std::size_t internalIndex = index % 32;
+    std::size_t internalIndex = index % 64;
     // All 0's except a 1 at 'internalIndex'.
-    std::uint32_t mask = 1 << internalIndex;
+    std::uint64_t mask = std::uint64_t (1) << internalIndex;
     // Extracts the value of the desired bit.
     return bool (storage[storageIndex] & mask);
 }
@@ -33,11 +41,11 @@ bool BitArray::Get (std::size_t index) const
 void BitArray::Set (std::size_t index)
 {
     // The index in 'storage' in which the desired bit lies.
-    std::size_t storageIndex = index / 32;
+    std::size_t storageIndex = index / 64;
     // The offset in 'storage[storageIndex]' at which the desired bit lies.
-    std::size_t internalIndex = index % 32;
+    std::size_t internalIndex = index % 64;
     // All 0's except a 1 at 'internalIndex'.
-    std::uint32_t valueMask = 1U << internalIndex;
+    std::uint64_t valueMask = std::uint64_t (1) << internalIndex;
     // Sets the desired bit.
     storage[storageIndex] |= valueMask;
 }
@@ -45,16 +53,137 @@ void BitArray::Set (std::size_t index)
 void BitArray::Reset (std::size_t index)
 {
     // The index in 'storage' in which the desired bit lies.
-    std::size_t storageIndex = index / 32;
+    std::size_t storageIndex = index / 64;
     // The offset in 'storage[storageIndex]' at which the desired bit lies.
-    std::size_t internalIndex = index % 32;
+    std::size_t internalIndex = index % 64;
     // All 1's except a 0 at 'internalIndex'.
-    std::uint32_t valueMask = ~(1U << internalIndex);
+    std::uint64_t valueMask = ~(std::uint64_t (1) << internalIndex);
     // Resets the desired bit.
     storage[storageIndex] &= valueMask;
 }
 
+std::size_t BitArray::ResetStride (std::size_t start, std::size_t end, std::size_t stride)
+{
+    // Kept in one tight loop so that the sieves calling this make one call per prime rather than one per bit.
+    std::uint64_t* words = storage.data ();
+    std::size_t index = start;
+
+    for (; index < end; index += stride)
+        words[index / 64] &= ~(std::uint64_t (1) << (index % 64));
+
+    return index;
+}
+
+// Copies 'wordCount' words from 'source' to 'destination' with the widest vector stores available.
+static void CopyWords (const std::uint64_t* source, std::uint64_t* destination, std::size_t wordCount)
+{
+    std::size_t i = 0;
+
+#if defined (__AVX2__)
+    for (; i + 4 <= wordCount; i += 4)
+        _mm256_storeu_si256
+        (
+            reinterpret_cast<__m256i*> (destination + i),
+            _mm256_loadu_si256 (reinterpret_cast<const __m256i*> (source + i))
+        );
+#elif defined (__SSE2__)
+    for (; i + 2 <= wordCount; i += 2)
+        _mm_storeu_si128
+        (
+            reinterpret_cast<__m128i*> (destination + i),
+            _mm_loadu_si128 (reinterpret_cast<const __m128i*> (source + i))
+        );
+#endif
+
+    // Scalar fallback, and the remainder after vector stores.
+    for (; i < wordCount; ++i)
+        destination[i] = source[i];
+}
+
+void BitArray::Stamp (std::size_t begin, std::size_t end, const BitArray& pattern, std::size_t patternBegin)
+{
+    std::size_t word = begin / 64;
+    std::size_t endWord = (end + 63) / 64;
+    std::size_t patternWord = patternBegin / 64 % pattern.storage.size ();
+
+    // Copy runs of words up to the end of 'pattern', wrapping back to its start after each run.
+    while (word < endWord)
+    {
+        std::size_t runLength = std::min (endWord - word, pattern.storage.size () - patternWord);
+        CopyWords (pattern.storage.data () + patternWord, storage.data () + word, runLength);
+        word += runLength;
+        patternWord = 0;
+    }
+}
+
 std::size_t BitArray::Count () const
 {
     return count;
 }
+
+std::size_t BitArray::CountSet () const
+{
+    return CountSet (0, count);
+}
+
+std::size_t BitArray::CountSet (std::size_t begin, std::size_t end) const
+{
+    if (begin >= end)
+        return 0;
+
+    std::size_t firstWord = begin / 64;
+    std::size_t lastWord = (end - 1) / 64;
+    // All 1's from 'begin' onwards within the first word, and all 1's before 'end' within the last word.
+    std::uint64_t firstMask = ~std::uint64_t (0) << (begin % 64);
+    std::uint64_t lastMask = ~std::uint64_t (0) >> (63 - (end - 1) % 64);
+
+    if (firstWord == lastWord)
+        return std::popcount (storage[firstWord] & firstMask & lastMask);
+
+    std::size_t total = std::popcount (storage[firstWord] & firstMask);
+
+    for (std::size_t i = firstWord + 1; i < lastWord; ++i)
+        total += std::popcount (storage[i]);
+
+    return total + std::popcount (storage[lastWord] & lastMask);
+}
+
+std::size_t BitArray::FindNextSet (std::size_t index) const
+{
+    if (index >= count)
+        return count;
+
+    std::size_t storageIndex = index / 64;
+    // Discard the bits before 'index' in its word.
+    std::uint64_t word = storage[storageIndex] & (~std::uint64_t (0) << (index % 64));
+
+    while (word == 0)
+    {
+        if (++storageIndex == storage.size ())
+            return count;
+
+        word = storage[storageIndex];
+    }
+
+    // The lowest true bit in 'word' is the one sought, unless it lies beyond 'count'.
+    std::size_t next = storageIndex * 64 + std::countr_zero (word);
+    return next < count ? next : count;
+}
+
+void BitArray::And (const BitArray& other)
+{
+    for (std::size_t i = 0; i < storage.size (); ++i)
+        storage[i] &= other.storage[i];
+}
+
+void BitArray::Or (const BitArray& other)
+{
+    for (std::size_t i = 0; i < storage.size (); ++i)
+        storage[i] |= other.storage[i];
+}
+
+void BitArray::AndNot (const BitArray& other)
+{
+    for (std::size_t i = 0; i < storage.size (); ++i)
+        storage[i] &= ~other.storage[i];
+}
@@ -9,7 +9,7 @@ class BitArray
 {
 private:
     // The underlying storage.
-    std::vector<std::uint32_t> storage;
+    std::vector<std::uint64_t> storage;
 
     // The number of bits stored.
     std::size_t count;
@@ -30,6 +30,39 @@ public:
     // Out of range indices result in undefined behaviour.
     void Reset (std::size_t index);
 
+    // Sets false the bits at 'start', 'start' + 'stride', 'start' + 2 * 'stride', ... that lie before 'end',
+    // and returns the index of the first such bit not before 'end'.
+    // 'stride' must be positive, and 'end' must not exceed 'Count ()'.
+    std::size_t ResetStride (std::size_t start, std::size_t end, std::size_t stride);
+
+    // Overwrites the bits in ['begin', 'end') with a periodic pattern: bit 'i' receives bit
+    // ('patternBegin' + 'i' - 'begin') modulo 'pattern.Count ()' of 'pattern'.
+    // 'begin', 'patternBegin' and 'pattern.Count ()' must be multiples of 64,
+    // and 'end' must be a multiple of 64 or equal to 'Count ()'.
+    void Stamp (std::size_t begin, std::size_t end, const BitArray& pattern, std::size_t patternBegin);
+
     // Returns the number of bits stored.
     std::size_t Count () const;
+
+    // Returns the number of true bits.
+    std::size_t CountSet () const;
+
+    // Returns the number of true bits in ['begin', 'end').
+    // 'end' must not exceed 'Count ()'.
+    std::size_t CountSet (std::size_t begin, std::size_t end) const;
+
+    // Returns the index of the first true bit not before 'index', or 'Count ()' if there is no such bit.
+    std::size_t FindNextSet (std::size_t index) const;
+
+    // Sets each bit to the conjunction of itself and the corresponding bit of 'other'.
+    // 'other' must have the same size.
+    void And (const BitArray& other);
+
+    // Sets each bit to the disjunction of itself and the corresponding bit of 'other'.
+    // 'other' must have the same size.
+    void Or (const BitArray& other);
+
+    // Sets false each bit whose corresponding bit of 'other' is true.
+    // 'other' must have the same size.
+    void AndNot (const BitArray& other);
 };
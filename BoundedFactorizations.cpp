@@ -1,5 +1,7 @@
 #include "BoundedFactorizations.h"
 
+#include <algorithm>
+#include <bit>
 #include <cstddef>
 #include <cstdint>
 #include <limits>
@@ -8,28 +10,16 @@
 
 #include "BoundedPrimeSets.h"
 #include "Exponent.h"
-#include "PrimeSieve.h"
+#include "PrimePool.h"
+#include "PrimeSieveCache.h"
 
 // Factorizations are ordered first by the set of distinct primes in lex order,
 // then by the exponent tuples in lex order.
 
 BoundedFactorizationIterator::BoundedFactorizationIterator (std::uint64_t upperBound)
-    : upperBound (upperBound),
-    factorization (std::make_shared<factorization_t> ()),
-    n (1),
-    isEnd (upperBound <= 1)
-{
-    // The pool will still exist even after 'sieve' has been destroyed.
-    PrimeSieve<std::uint64_t> sieve (upperBound);
-    primePool = sieve.Primes ();
-    bpsi = std::make_unique<BoundedPrimeSetIterator> (upperBound, primePool);
-}
+    : BoundedFactorizationIterator (upperBound, DefaultPrimeSieveCache ().Get (upperBound)) {}
 
-BoundedFactorizationIterator::BoundedFactorizationIterator
-(
-    std::uint64_t upperBound,
-    std::shared_ptr<const primes_t> primePool
-)
+BoundedFactorizationIterator::BoundedFactorizationIterator (std::uint64_t upperBound, PrimePool primePool)
     : upperBound (upperBound),
     primePool (primePool),
     factorization (std::make_shared<factorization_t> ()),
@@ -114,3 +104,138 @@ std::int32_t BoundedFactorizationIterator::MoebiusN () const
     // Efficient (-1)^n algorithm.
     return (-(factorization->size () & 1)) | 1;
 }
+
+// Appends to 'tasks' subtrees covering 'prefix', the factorization of 'n', and every factorization extending it
+// by primes of which the least is 'first.prime' or later, or none if not 'hasFirst'.
+// Extensions by a prime 'q' are estimated to number at most ('upperBound' - 1) / ('n' * 'q'); those estimated at
+// 'grain' or more are split recursively, while the rest are gathered into runs of consecutive primes.
+static void SplitBoundedFactorizations
+(
+    std::uint64_t upperBound,
+    const PrimePool& primePool,
+    std::uint64_t grain,
+    factorization_t& prefix,
+    std::uint64_t n,
+    std::int32_t mu,
+    PrimePool::Cursor first,
+    bool hasFirst,
+    std::vector<BoundedFactorizationTask>& tasks
+)
+{
+    // The greatest prime 'q' for which 'n' * 'q' is less than 'upperBound'.
+    std::uint64_t quotient = (upperBound - 1) / n;
+
+    if (quotient < grain || !hasFirst)
+    {
+        // The whole subtree is small enough to traverse at once.
+        tasks.emplace_back (prefix, n, mu, true, hasFirst, first, std::numeric_limits<std::uint64_t>::max ());
+        return;
+    }
+
+    // The run of consecutive primes being gathered, which also covers 'prefix' itself if it is the first run.
+    bool visitPrefix = true;
+    bool hasRun = false;
+    PrimePool::Cursor runFirst {};
+    std::uint64_t runSize = 0;
+
+    auto endRun = [&] (std::uint64_t end)
+    {
+        if (hasRun || visitPrefix)
+            tasks.emplace_back (prefix, n, mu, visitPrefix, hasRun, runFirst, end);
+
+        visitPrefix = false;
+        hasRun = false;
+        runSize = 0;
+    };
+
+    PrimePool::Cursor cursor = first;
+    bool hasCursor = true;
+
+    // Primes whose square times 'n' is less than 'upperBound' head subtrees of more than one factorization.
+    for (; hasCursor && cursor.prime <= quotient / cursor.prime; hasCursor = primePool.Next (cursor))
+    {
+        std::uint64_t prime = cursor.prime;
+
+        if (quotient / prime < grain)
+        {
+            if (!hasRun)
+            {
+                hasRun = true;
+                runFirst = cursor;
+            }
+
+            runSize += quotient / prime;
+
+            if (runSize >= grain)
+                endRun (prime + 1);
+
+            continue;
+        }
+
+        endRun (prime);
+
+        // Split the subtree below each power of 'prime' separately.
+        PrimePool::Cursor next = cursor;
+        bool hasNext = primePool.Next (next);
+        std::uint64_t m = n;
+        std::int32_t mMu = -mu;
+        prefix.emplace_back (prime, 0);
+
+        while (prime <= (upperBound - 1) / m)
+        {
+            m *= prime;
+            ++prefix.back ().power;
+            SplitBoundedFactorizations (upperBound, primePool, grain, prefix, m, mMu, next, hasNext, tasks);
+            mMu = 0;
+        }
+
+        prefix.pop_back ();
+    }
+
+    if (!hasCursor || cursor.prime > quotient)
+    {
+        endRun (std::numeric_limits<std::uint64_t>::max ());
+        return;
+    }
+
+    endRun (cursor.prime);
+
+    // The remaining primes up to 'quotient' each extend 'prefix' by themselves alone, so they are split into chunks
+    // by value, each holding on the order of 'grain' primes.
+    std::uint64_t chunkSize
+        = std::min (grain, std::numeric_limits<std::uint64_t>::max () / 64) * std::bit_width (quotient);
+
+    for (std::uint64_t chunkStart = cursor.prime; chunkStart <= quotient; )
+    {
+        std::uint64_t chunkEnd = quotient - chunkStart >= chunkSize ? chunkStart + chunkSize : quotient + 1;
+        PrimePool::Cursor chunkFirst;
+
+        if (!primePool.Seek (chunkStart, chunkFirst))
+            break;
+
+        if (chunkFirst.prime < chunkEnd)
+            tasks.emplace_back (prefix, n, mu, false, true, chunkFirst, chunkEnd);
+
+        chunkStart = chunkEnd;
+    }
+}
+
+std::vector<BoundedFactorizationTask> PartitionBoundedFactorizations
+(
+    std::uint64_t upperBound,
+    const PrimePool& primePool,
+    std::size_t taskCount
+)
+{
+    std::vector<BoundedFactorizationTask> tasks;
+
+    if (upperBound <= 1)
+        return tasks;
+
+    std::uint64_t grain = std::max (std::uint64_t (1), upperBound / std::max (std::size_t (1), taskCount));
+    factorization_t prefix;
+    PrimePool::Cursor first;
+    bool hasFirst = primePool.First (first);
+    SplitBoundedFactorizations (upperBound, primePool, grain, prefix, 1, 1, first, hasFirst, tasks);
+    return tasks;
+}
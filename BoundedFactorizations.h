@@ -1,11 +1,21 @@
 #pragma once
 
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
 #include <cstdint>
+#include <limits>
 #include <memory>
+#include <span>
+#include <thread>
+#include <utility>
 #include <vector>
 
 #include "BoundedPrimeSets.h"
+#include "Exponent.h"
+#include "PrimePool.h"
 #include "PrimePower.h"
+#include "PrimeSieveCache.h"
 
 using primes_t = std::vector<std::uint64_t>;
 using factorization_t = std::vector<PrimePower<std::uint64_t, std::uint32_t>>;
@@ -14,6 +24,7 @@ using factorization_t = std::vector<PrimePower<std::uint64_t, std::uint32_t>>;
 // The set is constrained by an upper bound on the integer corresponding
 // to each factorization, and by a predetermined pool of primes
 // from which to construct the factorizations.
+// Where every element need only be visited once, 'ForEachBoundedFactorization' is several times faster.
 class BoundedFactorizationIterator
 {
 private:
@@ -21,7 +32,7 @@ private:
     std::uint64_t upperBound;
 
     // The prime pool.
-    std::shared_ptr<const primes_t> primePool;
+    PrimePool primePool;
 
     // The current factorization.
     std::shared_ptr<factorization_t> factorization;
@@ -37,11 +48,12 @@ private:
 
 public:
     // Constructs a BoundedFactorizationIterator with given upper bound.
-    // The prime pool is constructed to be the set of primes less than the upper bound.
+    // The prime pool is read directly from a sieve shared through 'DefaultPrimeSieveCache ()',
+    // which contains at least the primes less than the upper bound.
     BoundedFactorizationIterator (std::uint64_t upperBound);
 
     // Constructs a BoundedFactorizationIterator with given upper bound and prime pool.
-    BoundedFactorizationIterator (std::uint64_t upperBound, std::shared_ptr<const primes_t> primePool);
+    BoundedFactorizationIterator (std::uint64_t upperBound, PrimePool primePool);
 
     // Returns the current factorization.
     std::shared_ptr<const factorization_t> Factorization () const;
@@ -58,3 +70,221 @@ public:
     // Returns the Moebius function of the integer corresponding to the current factorization.
     std::int32_t MoebiusN () const;
 };
+
+// A subtree of the search tree of factorizations bounded by an upper bound, to be traversed independently of the rest.
+// The subtree consists of the factorization 'prefix', if 'visitPrefix', together with every factorization extending
+// 'prefix' by primes of which the least lies in ['first.prime', 'end'), or none if not 'hasFirst'.
+struct BoundedFactorizationTask
+{
+    // The factorization common to the subtree.
+    factorization_t prefix;
+
+    // The integer corresponding to 'prefix'.
+    std::uint64_t n;
+
+    // The Moebius function of 'n'.
+    std::int32_t mu;
+
+    // Whether 'prefix' itself belongs to the subtree.
+    bool visitPrefix;
+
+    // Whether any factorization extending 'prefix' belongs to the subtree.
+    bool hasFirst;
+
+    // The position in the prime pool of the least prime that may extend 'prefix'.
+    PrimePool::Cursor first;
+
+    // The exclusive upper bound on the least prime extending 'prefix'.
+    std::uint64_t end;
+};
+
+// Splits the factorizations whose integers are less than 'upperBound' and whose primes are drawn from 'primePool'
+// into disjoint subtrees which together cover them all, each estimated to contain not many more than
+// 'upperBound' / 'taskCount' factorizations.
+std::vector<BoundedFactorizationTask> PartitionBoundedFactorizations
+(
+    std::uint64_t upperBound,
+    const PrimePool& primePool,
+    std::size_t taskCount
+);
+
+// The prime factorization passed to a visitor, in increasing order of primes.
+using factorization_span_t = std::span<const PrimePower<std::uint64_t, std::uint32_t>>;
+
+// Calls 'visitor' ('m', 'factorization', 'mu') on every factorization extending 'factorization', the factorization
+// of 'n', whose integer 'm' is less than 'upperBound' and whose least additional prime is 'first.prime' or a later
+// prime of 'primePool' less than 'end'.
+// Standard depth first search algorithm, appending to and restoring 'factorization' in place, so that the partial
+// products live on the call stack and nothing is allocated.
+template<typename Visitor>
+void VisitBoundedFactorizations
+(
+    std::uint64_t upperBound,
+    const PrimePool& primePool,
+    PrimeFactorsBuffer<std::uint64_t>& factorization,
+    std::uint64_t n,
+    std::int32_t mu,
+    PrimePool::Cursor first,
+    std::uint64_t end,
+    Visitor& visitor
+)
+{
+    // Bounds are compared against products widened to 128 bits rather than quotients, sparing a division per step.
+    using wide_t = unsigned __int128;
+    PrimePool::Cursor cursor = first;
+    bool hasCursor = true;
+
+    for (; hasCursor; hasCursor = primePool.Next (cursor))
+    {
+        std::uint64_t prime = cursor.prime;
+
+        if (prime >= end || wide_t (n) * prime >= upperBound)
+            return;
+
+        // A prime whose square times 'n' reaches 'upperBound' cannot divide the integer again,
+        // nor be followed by a greater prime, so it and every later prime extend 'n' only by themselves.
+        if (wide_t (n) * prime * prime >= upperBound)
+            break;
+
+        // Visit each power of 'prime' in turn, followed by its extensions by later primes.
+        std::uint64_t m = n * prime;
+        std::int32_t mMu = -mu;
+        factorization.emplace_back (prime, 1);
+
+        while (true)
+        {
+            visitor (m, factorization_span_t (factorization.begin (), factorization.size ()), mMu);
+
+            // Every later prime exceeds 'prime', so checking 'prime' + 1 first skips a search of the pool.
+            PrimePool::Cursor next = cursor;
+
+            if (wide_t (m) * (prime + 1) < upperBound && primePool.Next (next))
+                VisitBoundedFactorizations
+                (
+                    upperBound,
+                    primePool,
+                    factorization,
+                    m,
+                    mMu,
+                    next,
+                    std::numeric_limits<std::uint64_t>::max (),
+                    visitor
+                );
+
+            if (wide_t (m) * prime >= upperBound)
+                break;
+
+            m *= prime;
+            ++factorization.back ().power;
+            mMu = 0;
+        }
+
+        factorization.pop_back ();
+    }
+
+    if (!hasCursor)
+        return;
+
+    // The remaining primes are leaves of the search tree.
+    factorization.emplace_back (cursor.prime, 1);
+
+    do
+    {
+        std::uint64_t prime = cursor.prime;
+
+        if (prime >= end || wide_t (n) * prime >= upperBound)
+            break;
+
+        factorization.back ().prime = prime;
+        visitor (n * prime, factorization_span_t (factorization.begin (), factorization.size ()), -mu);
+    }
+    while (primePool.Next (cursor));
+
+    factorization.pop_back ();
+}
+
+// Calls 'visitor' ('n', 'factorization', 'mu') on every factorization whose integer 'n' is less than 'upperBound'
+// and whose primes are drawn from 'primePool', where 'factorization' is the prime factorization of 'n' in increasing
+// order of primes as a 'factorization_span_t', valid only for the duration of the call, and 'mu' is the Moebius
+// function of 'n'.
+// The search tree is split into subtrees by 'PartitionBoundedFactorizations', which up to 'threadCount' threads take
+// in turn from a shared queue until it is empty, so 'visitor' may be called concurrently and must be safe to call so.
+// The order in which factorizations are visited is unspecified.
+template<typename Visitor>
+void ForEachBoundedFactorization
+(
+    std::uint64_t upperBound,
+    PrimePool primePool,
+    Visitor&& visitor,
+    std::size_t threadCount = 1
+)
+{
+    // Each thread should receive many subtrees, so that those finishing early can take on more.
+    constexpr std::size_t tasksPerThread = 64;
+
+    if (upperBound <= 1)
+        return;
+
+    threadCount = std::max (std::size_t (1), threadCount);
+    std::vector<BoundedFactorizationTask> tasks = PartitionBoundedFactorizations
+    (
+        upperBound,
+        primePool,
+        threadCount == 1 ? 1 : threadCount * tasksPerThread
+    );
+    std::atomic<std::size_t> nextTask (0);
+
+    auto visitTasks = [&] ()
+    {
+        PrimeFactorsBuffer<std::uint64_t> factorization;
+
+        for (std::size_t task = nextTask++; task < tasks.size (); task = nextTask++)
+        {
+            const BoundedFactorizationTask& subtree = tasks[task];
+            factorization.clear ();
+
+            for (const auto& primePower : subtree.prefix)
+                factorization.emplace_back (primePower);
+
+            if (subtree.visitPrefix)
+                visitor (subtree.n, factorization_span_t (factorization.begin (), factorization.size ()), subtree.mu);
+
+            if (subtree.hasFirst)
+                VisitBoundedFactorizations
+                (
+                    upperBound,
+                    primePool,
+                    factorization,
+                    subtree.n,
+                    subtree.mu,
+                    subtree.first,
+                    subtree.end,
+                    visitor
+                );
+        }
+    };
+
+    std::vector<std::thread> threads;
+
+    for (std::size_t thread = 1; thread < threadCount; ++thread)
+        threads.emplace_back (visitTasks);
+
+    visitTasks ();
+
+    for (std::thread& thread : threads)
+        thread.join ();
+}
+
+// Calls 'visitor' ('n', 'factorization', 'mu') on every factorization whose integer 'n' is less than 'upperBound',
+// as above, reading the prime pool directly from a sieve shared through 'DefaultPrimeSieveCache ()'.
+template<typename Visitor>
+void ForEachBoundedFactorization (std::uint64_t upperBound, Visitor&& visitor, std::size_t threadCount = 1)
+{
+    ForEachBoundedFactorization
+    (
+        upperBound,
+        PrimePool (DefaultPrimeSieveCache ().Get (upperBound, threadCount)),
+        std::forward<Visitor> (visitor),
+        threadCount
+    );
+}
@@ -6,52 +6,64 @@
 #include <memory>
 #include <vector>
 
-#include "PrimeSieve.h"
+#include "PrimePool.h"
+#include "PrimeSieveCache.h"
 
 // Sets are ordered in lex order, and each set is represented in increasing order.
 
 BoundedPrimeFixedSizeSetIterator::BoundedPrimeFixedSizeSetIterator (std::uint64_t upperBound, std::uint32_t setSize)
-    : upperBound (upperBound),
-    setSize (setSize)
-{
-    // The pool will still exist even after 'sieve' has been destroyed.
-    PrimeSieve<std::uint64_t> sieve (upperBound);
-    primePool = sieve.Primes ();
-    primes = std::make_shared<primes_t> ();
-
-    // The first subset of 'primePool' of size 'setSize' in lex order
-    // is the set consisting of the smallest 'setSize' primes in 'primePool'.
-    n = 1;
-
-    for (std::size_t i = 0; i < setSize; ++i)
-    {
-        indices.emplace_back (i);
-        primes->emplace_back ((*primePool)[i]);
-        n *= (*primePool)[i];
-    }
-
-    isEnd = (n >= upperBound);
-}
+    : BoundedPrimeFixedSizeSetIterator
+    (
+        upperBound,
+        setSize,
+        DefaultPrimeSieveCache ().Get (upperBound)
+    ) {}
 
 BoundedPrimeFixedSizeSetIterator::BoundedPrimeFixedSizeSetIterator
 (
     std::uint64_t upperBound,
     std::uint32_t setSize,
-    std::shared_ptr<const primes_t> primePool
+    PrimePool primePool
 )
     : upperBound (upperBound),
     setSize (setSize),
-    primePool (primePool)
+    primePool (primePool),
+    primes (std::make_shared<primes_t> ())
 {
     // The first subset of 'primePool' of size 'setSize' in lex order
     // is the set consisting of the smallest 'setSize' primes in 'primePool'.
+    using wide_t = unsigned __int128;
     n = 1;
+    prefixProducts.emplace_back (n);
+    PrimePool::Cursor cursor;
+
+    if (setSize > 0 && !primePool.First (cursor))
+    {
+        isEnd = true;
+        return;
+    }
 
     for (std::size_t i = 0; i < setSize; ++i)
     {
-        indices.emplace_back (i);
-        primes->emplace_back ((*primePool)[i]);
-        n *= (*primePool)[i];
+        if (i > 0 && !primePool.Next (cursor))
+        {
+            // 'primePool' has fewer than 'setSize' primes.
+            isEnd = true;
+            return;
+        }
+
+        cursors.emplace_back (cursor);
+        primes->emplace_back (cursor.prime);
+
+        if (wide_t (n) * cursor.prime >= upperBound)
+        {
+            // Even the least set is too large, and its product may not fit.
+            isEnd = true;
+            return;
+        }
+
+        n *= cursor.prime;
+        prefixProducts.emplace_back (n);
     }
 
     isEnd = (n >= upperBound);
@@ -73,49 +85,77 @@ void BoundedPrimeFixedSizeSetIterator::operator++ ()
     // starting at the highest possible index in 'primes' and moving backwards,
     // and updating the subsequent primes in 'primes' as necessary
     // to preserve the increasing order and lex order properties.
-    std::size_t toIncrement = indices.size () - 1;
+    // Products are compared against 'upperBound' widened to 128 bits, so that they cannot overflow.
+    using wide_t = unsigned __int128;
+    std::size_t toIncrement = cursors.size () - 1;
 
     while (true)
     {
-        // If the current guess for 'toIncrement' is correct, 'newLastIndex'
-        // contains the index in 'primePool' of the last prime in the correct new value of 'primes'
-        std::size_t newLastIndex = indices[toIncrement] + indices.size () - toIncrement;
+        if (toIncrement == std::numeric_limits<std::size_t>::max ())
+        {
+            // All valid prime sets have already been observed.
+            // Enter the end state.
+            isEnd = true;
+            return;
+        }
+
+        // If the current guess for 'toIncrement' is correct, the correct tail
+        // of 'primes' starting at 'toIncrement' will be the run of consecutive primes in 'primePool'
+        // starting at the successor of the prime at 'toIncrement'.
+        // This can be deduced by considering the increasing order and lex order properties.
+        // Only the tail changes, so its products are built on the unchanged prefix product.
+        PrimePool::Cursor cursor = cursors[toIncrement];
+        std::uint64_t product = prefixProducts[toIncrement];
+        bool isValid = true;
 
-        if (newLastIndex < primePool->size ())
+        for (std::size_t i = toIncrement; i < cursors.size (); ++i)
         {
-            // 'primePool' has enough primes to accommodate the current guess for 'toIncrement'.
-            // If the current guess for 'toIncrement' is correct, the correct tail
-            // of 'primes' starting at 'toIncrement' will be the subsequence of
-            // 'primePool' starting at 'indices[toIncrement] + 1' and ending at 'indices[newLastIndex]'
-            // This can be deduced by considering the increasing order and lex order properties.
-            for (std::size_t i = toIncrement, j = indices[toIncrement] + 1; i < indices.size (); ++i, ++j)
+            if (!primePool.Next (cursor))
             {
-                indices[i] = j;
-                (*primes)[i] = (*primePool)[j];
+                // 'primePool' has too few primes to accommodate the current guess for 'toIncrement'.
+                isValid = false;
+                break;
             }
 
-            n = 1;
+            // The primes to be appended are each at least the first of them, so if the product would reach
+            // 'upperBound' with every one of them equal to it, the whole subtree is dead and the search steps
+            // straight up to the parent; otherwise each later prime appended only needs checking once.
+            if (i == toIncrement)
+            {
+                wide_t least = product;
 
-            for (std::uint64_t prime : *primes)
-                n *= prime;
+                for (std::size_t j = i; j < cursors.size () && least < upperBound; ++j)
+                    least *= cursor.prime;
 
-            if (n < upperBound)
-                // The current guess for 'toIncrement' is correct, and
-                // the current state of 'primes' and 'indices' is a valid state for the iterator.
-                return;
-        }
+                if (least >= upperBound)
+                {
+                    isValid = false;
+                    break;
+                }
+            }
+            else if (wide_t (product) * cursor.prime >= upperBound)
+            {
+                isValid = false;
+                break;
+            }
 
-        // The current guess for 'toIncrement' is incorrect.
-        // Step up one level in the search tree by decrementing 'toIncrement'.
-        --toIncrement;
+            cursors[i] = cursor;
+            (*primes)[i] = cursor.prime;
+            product *= cursor.prime;
+            prefixProducts[i + 1] = product;
+        }
 
-        if (toIncrement == std::numeric_limits<std::size_t>::max ())
+        if (isValid)
         {
-            // All valid prime sets have already been observed.
-            // Enter the end state.
-            isEnd = true;
+            // The current guess for 'toIncrement' is correct, and
+            // the current state of 'primes' and 'cursors' is a valid state for the iterator.
+            n = product;
             return;
         }
+
+        // The current guess for 'toIncrement' is incorrect.
+        // Step up one level in the search tree by decrementing 'toIncrement'.
+        --toIncrement;
     }
 }
 
@@ -129,3 +169,67 @@ std::int32_t BoundedPrimeFixedSizeSetIterator::MoebiusN () const
     // Efficient (-1)^n algorithm.
     return (-(setSize & 1)) | 1;
 }
+
+// Returns the number of extensions of the prime set of product 'n' by 'remaining' further primes whose least
+// additional prime is 'first.prime' or a later prime of 'primePool' and whose product is less than 'upperBound'.
+// 'remaining' must be positive.
+static std::uint64_t CountExtensions
+(
+    std::uint64_t upperBound,
+    const PrimePool& primePool,
+    std::uint64_t n,
+    std::uint32_t remaining,
+    PrimePool::Cursor first
+)
+{
+    // The choices of the last prime are counted all at once.
+    if (remaining == 1)
+        return primePool.CountTo (first, (upperBound - 1) / n);
+
+    using wide_t = unsigned __int128;
+    std::uint64_t count = 0;
+    PrimePool::Cursor cursor = first;
+
+    do
+    {
+        // The remaining primes are each at least 'prime', so once 'n' * 'prime'^'remaining' reaches 'upperBound'
+        // neither this nor any later subtree holds a valid set.
+        std::uint64_t prime = cursor.prime;
+        wide_t least = n;
+
+        for (std::uint32_t i = 0; i < remaining; ++i)
+            if ((least *= prime) >= upperBound)
+                return count;
+
+        PrimePool::Cursor next = cursor;
+
+        if (!primePool.Next (next))
+            return count;
+
+        count += CountExtensions (upperBound, primePool, n * prime, remaining - 1, next);
+    }
+    while (primePool.Next (cursor));
+
+    return count;
+}
+
+std::uint64_t CountBoundedPrimeFixedSizeSets (std::uint64_t upperBound, std::uint32_t setSize, PrimePool primePool)
+{
+    if (upperBound <= 1)
+        return 0;
+
+    if (setSize == 0)
+        return 1;
+
+    PrimePool::Cursor first;
+
+    if (!primePool.First (first))
+        return 0;
+
+    return CountExtensions (upperBound, primePool, 1, setSize, first);
+}
+
+std::uint64_t CountBoundedPrimeFixedSizeSets (std::uint64_t upperBound, std::uint32_t setSize)
+{
+    return CountBoundedPrimeFixedSizeSets (upperBound, setSize, DefaultPrimeSieveCache ().Get (upperBound));
+}
@@ -1,16 +1,25 @@
 #pragma once
 
-#include <cstddef>
 #include <cstdint>
 #include <memory>
+#include <span>
+#include <utility>
 #include <vector>
 
+#include "FixedVector.h"
+#include "PrimePool.h"
+#include "PrimePower.h"
+#include "PrimeSieveCache.h"
+
 using primes_t = std::vector<std::uint64_t>;
-using indices_t = std::vector<std::size_t>;
+
+// The prime set passed to a visitor, in increasing order.
+using primes_span_t = std::span<const std::uint64_t>;
 
 // Iterates through a specified set of fixed-size sets of primes.
 // The set is constrained by an upper bound on the product of each prime set,
 // and by a predetermined pool of primes of which each prime set must be a subset.
+// Where every element need only be visited once, 'ForEachBoundedPrimeFixedSizeSet' is several times faster.
 class BoundedPrimeFixedSizeSetIterator
 {
 private:
@@ -21,14 +30,17 @@ private:
     std::uint32_t setSize;
 
     // The prime pool.
-    std::shared_ptr<const primes_t> primePool;
+    PrimePool primePool;
 
-    // The indices in 'primePool' of the current prime set.
-    indices_t indices;
+    // The positions in 'primePool' of the current prime set.
+    std::vector<PrimePool::Cursor> cursors;
 
     // The current set.
     std::shared_ptr<primes_t> primes;
 
+    // The product of the first 'i' primes of the current set at index 'i', for 'i' in [0, 'setSize'].
+    std::vector<std::uint64_t> prefixProducts;
+
     // The product of the current prime set.
     std::uint64_t n;
 
@@ -37,7 +49,8 @@ private:
 
 public:
     // Constructs a BoundedPrimeFixedSizeSetIterator with the given upper bound and set size.
-    // The prime pool is constructed to be the set of primes less than the upper bound.
+    // The prime pool is read directly from a sieve shared through 'DefaultPrimeSieveCache ()',
+    // which contains at least the primes less than the upper bound.
     BoundedPrimeFixedSizeSetIterator (std::uint64_t upperBound, std::uint32_t setSize);
 
     // Constructs a BoundedPrimeFixedSizeSetIterator with the given upper bound, set size, and prime pool.
@@ -45,7 +58,7 @@ public:
     (
         std::uint64_t upperBound,
         std::uint32_t setSize,
-        std::shared_ptr<const primes_t> primePool
+        PrimePool primePool
     );
 
     // Returns the current prime set.
@@ -63,3 +76,124 @@ public:
     // Returns the Moebius function of the product of the current prime set.
     std::int32_t MoebiusN () const;
 };
+
+// Returns the number of sets of 'setSize' primes drawn from 'primePool' whose product is less than 'upperBound'.
+// Only the sets of fewer primes that can still be completed are visited; the choices of the last prime are counted
+// in bulk through 'PrimePool::CountTo'.
+std::uint64_t CountBoundedPrimeFixedSizeSets (std::uint64_t upperBound, std::uint32_t setSize, PrimePool primePool);
+
+// Returns the number of sets of 'setSize' primes whose product is less than 'upperBound', as above,
+// reading the prime pool directly from a sieve shared through 'DefaultPrimeSieveCache ()'.
+std::uint64_t CountBoundedPrimeFixedSizeSets (std::uint64_t upperBound, std::uint32_t setSize);
+
+// Calls 'visitor' ('m', 'primes') on every prime set extending 'primes', the prime set of product 'n', by 'remaining'
+// further primes, whose product 'm' is less than 'upperBound' and whose least additional prime is 'first.prime'
+// or a later prime of 'primePool'.
+// Standard depth first search algorithm, appending to and restoring 'primes' in place, so that the partial products
+// live on the call stack and nothing is allocated.
+// 'remaining' must be positive.
+template<typename Visitor>
+void VisitBoundedPrimeFixedSizeSets
+(
+    std::uint64_t upperBound,
+    const PrimePool& primePool,
+    FixedVector<std::uint64_t, maximumPrimeFactorCount>& primes,
+    std::uint32_t remaining,
+    std::uint64_t n,
+    PrimePool::Cursor first,
+    Visitor& visitor
+)
+{
+    // Bounds are compared against products widened to 128 bits rather than quotients, sparing a division per step.
+    using wide_t = unsigned __int128;
+    PrimePool::Cursor cursor = first;
+
+    if (remaining == 1)
+    {
+        // The last prime of each set is a leaf of the search tree.
+        primes.emplace_back (cursor.prime);
+
+        do
+        {
+            std::uint64_t prime = cursor.prime;
+
+            if (wide_t (n) * prime >= upperBound)
+                break;
+
+            primes.back () = prime;
+            visitor (n * prime, primes_span_t (primes.begin (), primes.size ()));
+        }
+        while (primePool.Next (cursor));
+
+        primes.pop_back ();
+        return;
+    }
+
+    do
+    {
+        // The remaining primes are each at least 'prime', so once 'n' * 'prime'^'remaining' reaches 'upperBound'
+        // neither this nor any later subtree holds a valid set.
+        std::uint64_t prime = cursor.prime;
+        wide_t least = n;
+
+        for (std::uint32_t i = 0; i < remaining; ++i)
+            if ((least *= prime) >= upperBound)
+                return;
+
+        PrimePool::Cursor next = cursor;
+
+        if (!primePool.Next (next))
+            return;
+
+        primes.emplace_back (prime);
+        VisitBoundedPrimeFixedSizeSets (upperBound, primePool, primes, remaining - 1, n * prime, next, visitor);
+        primes.pop_back ();
+    }
+    while (primePool.Next (cursor));
+}
+
+// Calls 'visitor' ('n', 'primes') on every set of 'setSize' primes drawn from 'primePool' whose product 'n' is less
+// than 'upperBound', where 'primes' is the set in increasing order as a 'primes_span_t', valid only for the duration
+// of the call.
+// Sets are visited in the same lex order as by BoundedPrimeFixedSizeSetIterator, but without allocation or reference
+// counting.
+template<typename Visitor>
+void ForEachBoundedPrimeFixedSizeSet
+(
+    std::uint64_t upperBound,
+    std::uint32_t setSize,
+    PrimePool primePool,
+    Visitor&& visitor
+)
+{
+    FixedVector<std::uint64_t, maximumPrimeFactorCount> primes;
+
+    // The product of any 'maximumPrimeFactorCount' + 1 distinct primes exceeds every 64-bit bound.
+    if (upperBound <= 1 || setSize > maximumPrimeFactorCount)
+        return;
+
+    if (setSize == 0)
+    {
+        visitor (std::uint64_t (1), primes_span_t (primes.begin (), primes.size ()));
+        return;
+    }
+
+    PrimePool::Cursor first;
+
+    if (primePool.First (first))
+        VisitBoundedPrimeFixedSizeSets (upperBound, primePool, primes, setSize, 1, first, visitor);
+}
+
+// Calls 'visitor' ('n', 'primes') on every set of 'setSize' primes whose product 'n' is less than 'upperBound',
+// as above, reading the prime pool directly from a sieve shared through 'DefaultPrimeSieveCache ()'.
+template<typename Visitor>
+void ForEachBoundedPrimeFixedSizeSet (std::uint64_t upperBound, std::uint32_t setSize, Visitor&& visitor)
+{
+    ForEachBoundedPrimeFixedSizeSet
+    (
+        upperBound,
+        setSize,
+        PrimePool (DefaultPrimeSieveCache ().Get (upperBound)),
+        std::forward<Visitor> (visitor)
+    );
+}
@@ -1,7 +1,9 @@
 #pragma once
 
+#include <cstddef>
 #include <cstdint>
 #include <memory>
+#include <span>
 #include <vector>
 
 #include "PrimePower.h"
@@ -9,10 +11,14 @@
 using primes_t = std::vector<std::uint64_t>;
 using factorization_t = std::vector<PrimePower<std::uint64_t, std::uint32_t>>;
 
+// The prime factorization passed to a visitor, in increasing order of primes.
+using factorization_span_t = std::span<const PrimePower<std::uint64_t, std::uint32_t>>;
+
 // Iterates through a specified set of prime factorizations.
 // The set is constrained by a predetermined pool of primes,
 // for each of which the factorization must have exponent at least 1,
 // and by an upper bound on the integer corresponding to each factorization.
+// Where every element need only be visited once, 'ForEachBoundedPrimeSetProduct' is several times faster.
 class BoundedPrimeSetProductIterator
 {
 private:
@@ -50,3 +56,76 @@ public:
     // Returns the Moebius function of the integer corresponding to the current factorization.
     std::int32_t MoebiusN () const;
 };
+
+// Calls 'visitor' ('m', 'factorization', 'mu') on every factorization obtained from 'factorization', that of 'n'
+// with Moebius function 'mu', by raising the powers of the primes at 'index' and later, whose integer 'm' is less
+// than 'upperBound'.
+// Standard depth first search algorithm, raising and restoring the powers in place, one prime per level of the tree.
+template<typename Visitor>
+void VisitBoundedPrimeSetProducts
+(
+    std::uint64_t upperBound,
+    PrimeFactorsBuffer<std::uint64_t>& factorization,
+    std::size_t index,
+    std::uint64_t n,
+    std::int32_t mu,
+    Visitor& visitor
+)
+{
+    if (index == factorization.size ())
+    {
+        visitor (n, factorization_span_t (factorization.begin (), factorization.size ()), mu);
+        return;
+    }
+
+    // Bounds are compared against products widened to 128 bits rather than quotients, sparing a division per step.
+    using wide_t = unsigned __int128;
+    auto& primePower = factorization[index];
+
+    while (true)
+    {
+        VisitBoundedPrimeSetProducts (upperBound, factorization, index + 1, n, mu, visitor);
+
+        if (wide_t (n) * primePower.prime >= upperBound)
+            break;
+
+        n *= primePower.prime;
+        ++primePower.power;
+        mu = 0;
+    }
+
+    primePower.power = 1;
+}
+
+// Calls 'visitor' ('n', 'factorization', 'mu') on every factorization in which each prime of 'primePool' appears
+// and no other, whose integer 'n' is less than 'upperBound', where 'factorization' is the prime factorization of 'n'
+// as a 'factorization_span_t', valid only for the duration of the call, and 'mu' is the Moebius function of 'n'.
+// Factorizations are visited in the same lex order of exponent tuples as by BoundedPrimeSetProductIterator,
+// but without allocation or reference counting.
+template<typename Visitor>
+void ForEachBoundedPrimeSetProduct
+(
+    std::uint64_t upperBound,
+    std::shared_ptr<const primes_t> primePool,
+    Visitor&& visitor
+)
+{
+    // The product of any 'maximumPrimeFactorCount' + 1 distinct primes exceeds every 64-bit bound.
+    if (upperBound <= 1 || primePool->size () > maximumPrimeFactorCount)
+        return;
+
+    PrimeFactorsBuffer<std::uint64_t> factorization;
+    unsigned __int128 n = 1;
+
+    for (std::uint64_t prime : *primePool)
+    {
+        factorization.emplace_back (prime, 1);
+
+        if ((n *= prime) >= upperBound)
+            return;
+    }
+
+    // Efficient (-1)^n algorithm.
+    std::int32_t mu = (-(factorization.size () & 1)) | 1;
+    VisitBoundedPrimeSetProducts (upperBound, factorization, 0, std::uint64_t (n), mu, visitor);
+}
@@ -1,29 +1,19 @@
 #include "BoundedPrimeSets.h"
 
+#include <cstddef>
 #include <cstdint>
 #include <memory>
 #include <vector>
 
-#include "PrimeSieve.h"
+#include "PrimePool.h"
+#include "PrimeSieveCache.h"
 
 // Sets are ordered in lex order, starting at the empty set, and each set is represented in increasing order.
 
 BoundedPrimeSetIterator::BoundedPrimeSetIterator (std::uint64_t upperBound)
-    : upperBound (upperBound),
-    primes (std::make_shared<primes_t> ()),
-    n (1),
-    isEnd (upperBound <= 1)
-{
-    // The pool will still exist even after 'sieve' has been destroyed.
-    PrimeSieve<std::uint64_t> sieve (upperBound);
-    primePool = sieve.Primes ();
-}
+    : BoundedPrimeSetIterator (upperBound, DefaultPrimeSieveCache ().Get (upperBound)) {}
 
-BoundedPrimeSetIterator::BoundedPrimeSetIterator
-(
-    std::uint64_t upperBound,
-    std::shared_ptr<const primes_t> primePool
-)
+BoundedPrimeSetIterator::BoundedPrimeSetIterator (std::uint64_t upperBound, PrimePool primePool)
     : upperBound (upperBound),
     primePool (primePool),
     primes (std::make_shared<primes_t> ()),
@@ -43,17 +33,19 @@ std::uint64_t BoundedPrimeSetIterator::N () const
 void BoundedPrimeSetIterator::operator++ ()
 {
     // Try to append to 'primes' the prime in 'primePool' succeeding the last prime in 'primes'.
-    if (indices.empty ())
+    if (cursors.empty ())
     {
         // The previous prime set was the empty set.
-        // The next set in lex order is the singleton containing 'primePool.front ()',
-        // assuming that prime is not larger than 'upperBound'.
-        if (primePool->front () < upperBound)
+        // The next set in lex order is the singleton containing the first prime in 'primePool',
+        // assuming that prime exists and is not larger than 'upperBound'.
+        PrimePool::Cursor first;
+
+        if (primePool.First (first) && first.prime < upperBound)
         {
-            // The singleton containing 'primePool.front ()' is valid.
-            indices.emplace_back (0);
-            primes->emplace_back (primePool->front ());
-            n = primes->front ();
+            // The singleton containing the first prime in 'primePool' is valid.
+            cursors.emplace_back (first);
+            primes->emplace_back (first.prime);
+            n = first.prime;
             return;
         }
 
@@ -63,31 +55,32 @@ void BoundedPrimeSetIterator::operator++ ()
         return;
     }
 
-    if (indices.back () < primePool->size () - 1)
+    PrimePool::Cursor next = cursors.back ();
+
+    if (primePool.Next (next))
     {
-        // There is a prime 'nextPrime' in 'primePool' greater than any prime in 'primes'.
-        // First try to append 'nextPrime' to 'primes'.
-        std::uint64_t nextPrime = (*primePool)[indices.back () + 1];
-        std::uint64_t nextN = n * nextPrime;
+        // There is a prime 'next.prime' in 'primePool' greater than any prime in 'primes'.
+        // First try to append 'next.prime' to 'primes'.
+        std::uint64_t nextN = n * next.prime;
 
         if (nextN < upperBound)
         {
-            // Appending 'nextPrime' results in a valid set.
-            indices.emplace_back (indices.back () + 1);
-            primes->emplace_back (nextPrime);
+            // Appending 'next.prime' results in a valid set.
+            cursors.emplace_back (next);
+            primes->emplace_back (next.prime);
             n = nextN;
             return;
         }
 
-        // Appending 'nextPrime' results in an invalid set.
-        // Instead of appending, try replacing the last prime in 'primes' with 'nextPrime'.
-        nextN = n / primes->back () * nextPrime;
+        // Appending 'next.prime' results in an invalid set.
+        // Instead of appending, try replacing the last prime in 'primes' with 'next.prime'.
+        nextN = n / primes->back () * next.prime;
 
         if (nextN < upperBound)
         {
-            // Replacing the last prime in 'primes' with 'nextPrime' results in a valid set.
-            ++indices.back ();
-            primes->back () = nextPrime;
+            // Replacing the last prime in 'primes' with 'next.prime' results in a valid set.
+            cursors.back () = next;
+            primes->back () = next.prime;
             n = nextN;
             return;
         }
@@ -99,9 +92,9 @@ void BoundedPrimeSetIterator::operator++ ()
         // Move up the search tree.
         n /= primes->back ();
         primes->pop_back ();
-        indices.pop_back ();
+        cursors.pop_back ();
 
-        if (indices.empty ())
+        if (cursors.empty ())
         {
             // All valid sets have already been observed.
             // Enter the end state.
@@ -110,14 +103,16 @@ void BoundedPrimeSetIterator::operator++ ()
         }
 
         // Try to replace the last prime with its successor in 'primePool'.
-        std::uint64_t nextPrime = (*primePool)[indices.back () + 1];
-        std::uint64_t nextN = n / primes->back () * nextPrime;
+        // The successor exists, since it was previously the last prime in 'primes'.
+        next = cursors.back ();
+        primePool.Next (next);
+        std::uint64_t nextN = n / primes->back () * next.prime;
 
         if (nextN < upperBound)
         {
             // Replacing the last prime in 'primes' with its successor in 'primePool' results in a valid set.
-            ++indices.back ();
-            primes->back () = nextPrime;
+            cursors.back () = next;
+            primes->back () = next.prime;
             n = nextN;
             return;
         }
@@ -134,3 +129,81 @@ std::int32_t BoundedPrimeSetIterator::MoebiusN () const
     // Efficient (-1)^n algorithm.
     return (-(primes->size () & 1)) | 1;
 }
+
+// Returns the sum of the weights of the non-empty extensions of the prime set of product 'n' whose least additional
+// prime is 'first.prime' or a later prime of 'primePool' and whose product is less than 'upperBound',
+// where an extension by 'i' primes has weight 'weight' * 'sign'^'i'.
+template<typename Sum>
+static Sum SumExtensions
+(
+    std::uint64_t upperBound,
+    const PrimePool& primePool,
+    std::uint64_t n,
+    Sum weight,
+    Sum sign,
+    PrimePool::Cursor first
+)
+{
+    // The extensions by a single prime are counted all at once.
+    std::uint64_t quotient = (upperBound - 1) / n;
+    Sum childWeight = weight * sign;
+    Sum sum = childWeight * Sum (primePool.CountTo (first, quotient));
+
+    // Extensions by more primes start with a prime 'prime' whose successor times 'n' * 'prime' is less than
+    // 'upperBound', which is only possible while 'prime' * ('prime' + 1) does not exceed 'quotient'.
+    PrimePool::Cursor cursor = first;
+
+    do
+    {
+        std::uint64_t prime = cursor.prime;
+
+        if (prime > quotient / (prime + 1))
+            break;
+
+        PrimePool::Cursor next = cursor;
+
+        if (!primePool.Next (next))
+            break;
+
+        sum += SumExtensions (upperBound, primePool, n * prime, childWeight, sign, next);
+    }
+    while (primePool.Next (cursor));
+
+    return sum;
+}
+
+std::uint64_t CountBoundedPrimeSets (std::uint64_t upperBound, PrimePool primePool)
+{
+    if (upperBound <= 1)
+        return 0;
+
+    PrimePool::Cursor first;
+
+    if (!primePool.First (first))
+        return 1;
+
+    return 1 + SumExtensions<std::uint64_t> (upperBound, primePool, 1, 1, 1, first);
+}
+
+std::uint64_t CountBoundedPrimeSets (std::uint64_t upperBound)
+{
+    return CountBoundedPrimeSets (upperBound, DefaultPrimeSieveCache ().Get (upperBound));
+}
+
+std::int64_t MertensBounded (std::uint64_t upperBound, PrimePool primePool)
+{
+    if (upperBound <= 1)
+        return 0;
+
+    PrimePool::Cursor first;
+
+    if (!primePool.First (first))
+        return 1;
+
+    return 1 + SumExtensions<std::int64_t> (upperBound, primePool, 1, 1, -1, first);
+}
+
+std::int64_t MertensBounded (std::uint64_t upperBound)
+{
+    return MertensBounded (upperBound, DefaultPrimeSieveCache ().Get (upperBound));
+}
@@ -1,16 +1,25 @@
 #pragma once
 
-#include <cstddef>
 #include <cstdint>
 #include <memory>
+#include <span>
+#include <utility>
 #include <vector>
 
+#include "FixedVector.h"
+#include "PrimePool.h"
+#include "PrimePower.h"
+#include "PrimeSieveCache.h"
+
 using primes_t = std::vector<std::uint64_t>;
-using indices_t = std::vector<std::size_t>;
+
+// The prime set passed to a visitor, in increasing order.
+using primes_span_t = std::span<const std::uint64_t>;
 
 // Iterates through a specified set of sets of primes.
 // The set is constrained by an upper bound on the product of each prime set,
 // and by a predetermined pool of primes of which each prime set must be a subset.
+// Where every element need only be visited once, 'ForEachBoundedPrimeSet' is several times faster.
 class BoundedPrimeSetIterator
 {
 private:
@@ -18,10 +27,10 @@ private:
     std::uint64_t upperBound;
 
     // The prime pool.
-    std::shared_ptr<const primes_t> primePool;
+    PrimePool primePool;
 
-    // The indices in 'primePool' of the current prime set.
-    indices_t indices;
+    // The positions in 'primePool' of the current prime set.
+    std::vector<PrimePool::Cursor> cursors;
 
     // The current prime set.
     std::shared_ptr<primes_t> primes;
@@ -34,11 +43,12 @@ private:
 
 public:
     // Constructs a BoundedPrimeSetIterator with the given upper bound.
-    // The prime pool is constructed to be the set of primes less than the upper bound.
+    // The prime pool is read directly from a sieve shared through 'DefaultPrimeSieveCache ()',
+    // which contains at least the primes less than the upper bound.
     BoundedPrimeSetIterator (std::uint64_t upperBound);
 
     // Constructs a BoundedPrimeSetIterator with the given upper bound and prime pool.
-    BoundedPrimeSetIterator (std::uint64_t upperBound, std::shared_ptr<const primes_t> primePool);
+    BoundedPrimeSetIterator (std::uint64_t upperBound, PrimePool primePool);
 
     // Returns the current prime set.
     std::shared_ptr<const primes_t> Primes () const;
@@ -55,3 +65,121 @@ public:
     // Returns the Moebius function of the product of the current prime set.
     std::int32_t MoebiusN () const;
 };
+
+// Returns the number of sets of primes drawn from 'primePool' whose product is less than 'upperBound',
+// including the empty set.
+// Only the sets that can be extended further are visited; those extended by one last prime are counted in bulk
+// through 'PrimePool::CountTo'.
+std::uint64_t CountBoundedPrimeSets (std::uint64_t upperBound, PrimePool primePool);
+
+// Returns the number of sets of primes whose product is less than 'upperBound', as above,
+// reading the prime pool directly from a sieve shared through 'DefaultPrimeSieveCache ()'.
+std::uint64_t CountBoundedPrimeSets (std::uint64_t upperBound);
+
+// Returns the sum of the Moebius function over the positive integers less than 'upperBound' whose primes are drawn
+// from 'primePool', counting as 'CountBoundedPrimeSets' does.
+std::int64_t MertensBounded (std::uint64_t upperBound, PrimePool primePool);
+
+// Returns the sum of the Moebius function over the positive integers less than 'upperBound', as above,
+// reading the prime pool directly from a sieve shared through 'DefaultPrimeSieveCache ()'.
+std::int64_t MertensBounded (std::uint64_t upperBound);
+
+// Calls 'visitor' ('m', 'primes', 'mu') on every prime set extending 'primes', the prime set of product 'n' and Moebius
+// function 'mu', whose product 'm' is less than 'upperBound' and whose least additional prime is 'first.prime'
+// or a later prime of 'primePool'.
+// Standard depth first search algorithm, appending to and restoring 'primes' in place, so that the partial products
+// live on the call stack and nothing is allocated.
+// Sets are visited in the same lex order as by BoundedPrimeSetIterator.
+template<typename Visitor>
+void VisitBoundedPrimeSets
+(
+    std::uint64_t upperBound,
+    const PrimePool& primePool,
+    FixedVector<std::uint64_t, maximumPrimeFactorCount>& primes,
+    std::uint64_t n,
+    std::int32_t mu,
+    PrimePool::Cursor first,
+    Visitor& visitor
+)
+{
+    // Bounds are compared against products widened to 128 bits rather than quotients, sparing a division per step.
+    using wide_t = unsigned __int128;
+    PrimePool::Cursor cursor = first;
+    bool hasCursor = true;
+
+    for (; hasCursor; hasCursor = primePool.Next (cursor))
+    {
+        std::uint64_t prime = cursor.prime;
+
+        if (wide_t (n) * prime >= upperBound)
+            return;
+
+        // Every later prime exceeds 'prime', so once 'n' * 'prime' * ('prime' + 1) reaches 'upperBound',
+        // 'prime' and every later prime extend 'n' only by themselves.
+        if (wide_t (n) * prime * (prime + 1) >= upperBound)
+            break;
+
+        std::uint64_t m = n * prime;
+        primes.emplace_back (prime);
+        visitor (m, primes_span_t (primes.begin (), primes.size ()), -mu);
+
+        PrimePool::Cursor next = cursor;
+
+        if (primePool.Next (next))
+            VisitBoundedPrimeSets (upperBound, primePool, primes, m, -mu, next, visitor);
+
+        primes.pop_back ();
+    }
+
+    if (!hasCursor)
+        return;
+
+    // The remaining primes are leaves of the search tree.
+    primes.emplace_back (cursor.prime);
+
+    do
+    {
+        std::uint64_t prime = cursor.prime;
+
+        if (wide_t (n) * prime >= upperBound)
+            break;
+
+        primes.back () = prime;
+        visitor (n * prime, primes_span_t (primes.begin (), primes.size ()), -mu);
+    }
+    while (primePool.Next (cursor));
+
+    primes.pop_back ();
+}
+
+// Calls 'visitor' ('n', 'primes', 'mu') on every set of primes drawn from 'primePool' whose product 'n' is less than
+// 'upperBound', starting at the empty set, where 'primes' is the set in increasing order as a 'primes_span_t', valid
+// only for the duration of the call, and 'mu' is the Moebius function of 'n'.
+// Sets are visited in the same lex order as by BoundedPrimeSetIterator, but without allocation or reference counting.
+template<typename Visitor>
+void ForEachBoundedPrimeSet (std::uint64_t upperBound, PrimePool primePool, Visitor&& visitor)
+{
+    if (upperBound <= 1)
+        return;
+
+    FixedVector<std::uint64_t, maximumPrimeFactorCount> primes;
+    visitor (std::uint64_t (1), primes_span_t (primes.begin (), primes.size ()), std::int32_t (1));
+
+    PrimePool::Cursor first;
+
+    if (primePool.First (first))
+        VisitBoundedPrimeSets (upperBound, primePool, primes, 1, 1, first, visitor);
+}
+
+// Calls 'visitor' ('n', 'primes', 'mu') on every set of primes whose product 'n' is less than 'upperBound', as above,
+// reading the prime pool directly from a sieve shared through 'DefaultPrimeSieveCache ()'.
+template<typename Visitor>
+void ForEachBoundedPrimeSet (std::uint64_t upperBound, Visitor&& visitor)
+{
+    ForEachBoundedPrimeSet
+    (
+        upperBound,
+        PrimePool (DefaultPrimeSieveCache ().Get (upperBound)),
+        std::forward<Visitor> (visitor)
+    );
+}
@@ -0,0 +1,100 @@
+#include "CompactFactorization.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+#include "Divisors.h"
+#include "PollardRho.h"
+#include "PrimePower.h"
+
+void CompactFactorization::Append (std::uint64_t prime, std::uint32_t power)
+{
+    // Only the greatest prime can reach 2^32, and then only to the first power, so it is implied by 'n'.
+    if (prime >> 32 != 0)
+    {
+        hasLargePrime = true;
+        primes[count] = 0;
+    }
+    else
+        primes[count] = std::uint32_t (prime);
+
+    powers[count] = std::uint8_t (power);
+    ++count;
+}
+
+CompactFactorization::CompactFactorization (std::uint64_t n)
+    : n (n),
+    count (0),
+    hasLargePrime (false)
+{
+    for (const auto& primePower : PollardRhoPrimeFactors (n))
+        Append (primePower.prime, primePower.power);
+}
+
+PrimeFactorsBuffer<std::uint64_t> CompactFactorization::PrimeFactors () const
+{
+    PrimeFactorsBuffer<std::uint64_t> primeFactors;
+    std::uint64_t cofactor = n;
+
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        if (hasLargePrime && i + 1 == count)
+        {
+            primeFactors.emplace_back (cofactor, 1);
+            break;
+        }
+
+        primeFactors.emplace_back (primes[i], powers[i]);
+
+        if (hasLargePrime)
+            cofactor /= IntegerPow (std::uint64_t (primes[i]), powers[i]);
+    }
+
+    return primeFactors;
+}
+
+std::vector<std::uint64_t> CompactFactorization::Factors () const
+{
+    std::vector<std::uint64_t> factors;
+    std::vector<std::uint64_t> buffer;
+    GenerateFactors (PrimeFactors (), factors, buffer);
+    return factors;
+}
+
+FactorizationMemo::FactorizationMemo (std::size_t maximumEntries)
+    : maximumEntries (maximumEntries) {}
+
+CompactFactorization FactorizationMemo::Get (std::uint64_t n)
+{
+    {
+        std::lock_guard<std::mutex> lock (factorizationsMutex);
+        auto factorization = factorizations.find (n);
+
+        if (factorization != factorizations.end ())
+            return factorization->second;
+    }
+
+    // Factor outside the lock so that threads querying different integers do not wait on each other.
+    CompactFactorization factorization (n);
+
+    std::lock_guard<std::mutex> lock (factorizationsMutex);
+
+    if (factorizations.size () < maximumEntries)
+        factorizations.emplace (n, factorization);
+
+    return factorization;
+}
+
+std::size_t FactorizationMemo::Size () const
+{
+    std::lock_guard<std::mutex> lock (factorizationsMutex);
+    return factorizations.size ();
+}
+
+void FactorizationMemo::Clear ()
+{
+    std::lock_guard<std::mutex> lock (factorizationsMutex);
+    factorizations.clear ();
+}
@@ -0,0 +1,300 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <numeric>
+#include <unordered_map>
+#include <vector>
+
+#include <gmpxx.h>
+
+#include "ArithmeticFunctions.h"
+#include "PrimePower.h"
+
+// A factorization of a positive 64-bit integer held by value in a fixed-size layout, with no heap allocation,
+// for storing many factorizations side by side or passing them around cheaply.
+// The accessors match those of Factorization.
+// Every prime factor but the greatest is less than 2^32, and the greatest is less than 2^32 or divides
+// the integer exactly once; in the latter case it is not stored but recovered by dividing out the others.
+class CompactFactorization
+{
+private:
+    // The integer.
+    std::uint64_t n;
+
+    // The distinct primes dividing 'n' in increasing order, of which the first 'count' are in use.
+    // If 'hasLargePrime', the last prime is at least 2^32 and is not stored.
+    std::array<std::uint32_t, maximumPrimeFactorCount> primes;
+
+    // The power of each prime in 'primes'.
+    std::array<std::uint8_t, maximumPrimeFactorCount> powers;
+
+    // The number of distinct primes dividing 'n'.
+    std::uint8_t count;
+
+    // Whether the greatest prime dividing 'n' is at least 2^32.
+    bool hasLargePrime;
+
+    // Appends the prime power 'prime'^'power' to the factorization.
+    void Append (std::uint64_t prime, std::uint32_t power);
+
+public:
+    // Constructs a CompactFactorization of 'n' by trial division by small primes followed by Pollard-Brent rho.
+    CompactFactorization (std::uint64_t n = 1);
+
+    // Constructs a CompactFactorization of 'n' from its prime factorization 'primeFactors',
+    // any sequence of PrimePower in increasing order of primes.
+    template<typename PrimeFactors>
+    CompactFactorization (std::uint64_t n, const PrimeFactors& primeFactors)
+        : n (n),
+        count (0),
+        hasLargePrime (false)
+    {
+        for (const auto& primePower : primeFactors)
+            Append (primePower.prime, primePower.power);
+    }
+
+    // Returns 'n'.
+    std::uint64_t N () const
+    {
+        return n;
+    }
+
+    // Returns the prime factorization of 'n'.
+    PrimeFactorsBuffer<std::uint64_t> PrimeFactors () const;
+
+    // Returns the number of distinct primes dividing 'n'.
+    std::size_t PrimeFactorsCount () const
+    {
+        return count;
+    }
+
+    // Returns the 'prime'-adic valuation of 'n'.
+    std::uint32_t PAdicValuation (std::uint64_t prime) const
+    {
+        return ::PAdicValuation (PrimeFactors (), prime);
+    }
+
+    // Returns the 'prime'-adic valuation of 'n'.
+    std::uint32_t NuP (std::uint64_t prime) const
+    {
+        return PAdicValuation (prime);
+    }
+
+    // Returns the number of distinct primes dividing 'n'.
+    std::size_t SmallOmega () const
+    {
+        return PrimeFactorsCount ();
+    }
+
+    // Returns the number of prime factors of 'n' with multiplicity.
+    std::size_t BigOmega () const
+    {
+        std::size_t sum = 0;
+
+        for (std::size_t i = 0; i < count; ++i)
+            sum += powers[i];
+
+        return sum;
+    }
+
+    // Returns the factors of 'n' in increasing order.
+    std::vector<std::uint64_t> Factors () const;
+
+    // Returns the number of factors of 'n'.
+    std::size_t FactorsCount () const
+    {
+        std::size_t factorsCount = 1;
+
+        for (std::size_t i = 0; i < count; ++i)
+            factorsCount *= powers[i] + 1;
+
+        return factorsCount;
+    }
+
+    // Returns the number of factors of 'n'.
+    std::size_t Tau () const
+    {
+        return FactorsCount ();
+    }
+
+    // Returns the sum of the proper factors of 'n', modulo 2^64.
+    std::uint64_t SumProperFactors () const
+    {
+        return Sigma1 () - n;
+    }
+
+    // Returns the sum of the divisors of 'n', modulo 2^64.
+    std::uint64_t Sigma1 () const
+    {
+        return SigmaK (1);
+    }
+
+    // Returns the sum of the 'k'-th powers of the divisors of 'n', modulo 2^64.
+    // Use 'TrySigmaK' or 'ExactSigmaK' where the sum may not fit.
+    std::uint64_t SigmaK (std::uint64_t k) const
+    {
+        return ::SigmaK (PrimeFactors (), k);
+    }
+
+    // Computes the sum of the 'k'-th powers of the divisors of 'n' into 'sigma' and returns true if it fits in an
+    // 'unsigned __int128', or returns false leaving 'sigma' unspecified otherwise.
+    bool TrySigmaK (std::uint64_t k, unsigned __int128& sigma) const
+    {
+        return ::TrySigmaK (PrimeFactors (), k, sigma);
+    }
+
+    // Returns the sum of the 'k'-th powers of the divisors of 'n' exactly.
+    mpz_class ExactSigmaK (std::uint64_t k) const
+    {
+        return ::ExactSigmaK (PrimeFactors (), k);
+    }
+
+    // Returns the number of integers in [0, 'n') coprime to 'n'.
+    std::uint64_t Totient () const
+    {
+        return ::Totient (n, PrimeFactors ());
+    }
+
+    // Returns the number of integers in [0, 'n') coprime to 'n'.
+    std::uint64_t EulerPhi () const
+    {
+        return Totient ();
+    }
+
+    // Returns the radical of 'n'.
+    std::uint64_t Radical () const
+    {
+        return ::Radical<std::uint64_t> (PrimeFactors ());
+    }
+
+    // Returns 0 if 'n' is not squarefree, 1 if 'n' has an even number of prime factors, and -1 otherwise.
+    std::int32_t MoebiusFunction () const
+    {
+        if (!IsSquarefree ())
+            return 0;
+
+        // Efficient (-1)^n algorithm.
+        return (-(count & 1)) | 1;
+    }
+
+    // Returns 0 if 'n' is not squarefree, 1 if 'n' has an even number of prime factors, and -1 otherwise.
+    std::int32_t Mu () const
+    {
+        return MoebiusFunction ();
+    }
+
+    // Returns -1 to the power of 'BigOmega ()'.
+    std::int32_t LiouvilleFunction () const
+    {
+        // Efficient (-1)^n algorithm.
+        return (-(BigOmega () & 1)) | 1;
+    }
+
+    // Returns -1 to the power of 'BigOmega ()'.
+    std::int32_t SmallLambda () const
+    {
+        return LiouvilleFunction ();
+    }
+
+    // Returns the least common multiple of the multiplicative orders of the integers in [0, 'n') coprime to 'n'.
+    std::uint64_t CarmichaelFunction () const
+    {
+        return ::CarmichaelFunction (n, PrimeFactors ());
+    }
+
+    // Returns the greatest common divisor of 'n' and 'other.n'.
+    std::uint64_t GCD (const CompactFactorization& other) const
+    {
+        return std::gcd (n, other.n);
+    }
+
+    // Returns the lowest common multiple of 'n' and 'other.n'.
+    std::uint64_t LCM (const CompactFactorization& other) const
+    {
+        return std::lcm (n, other.n);
+    }
+
+    // Returns whether 'n' is prime.
+    bool IsPrime () const
+    {
+        return count == 1 && powers[0] == 1;
+    }
+
+    // Returns whether 'n' is composite.
+    bool IsComposite () const
+    {
+        return BigOmega () > 1;
+    }
+
+    // Returns whether 'n' is coprime to 'other.n'.
+    bool IsCoprime (const CompactFactorization& other) const
+    {
+        return GCD (other) == 1;
+    }
+
+    // Returns whether 'n' is 'h'-free; that is, whether no 'h'-th power divides 'n'.
+    bool IsHFree (std::uint32_t h) const
+    {
+        for (std::size_t i = 0; i < count; ++i)
+            if (powers[i] >= h)
+                return false;
+
+        return true;
+    }
+
+    // Returns whether 'n' is squarefree.
+    bool IsSquarefree () const
+    {
+        return IsHFree (2);
+    }
+
+    // Returns whether 'n' is perfect (equal to the sum of its proper factors).
+    bool IsPerfect () const
+    {
+        return SumProperFactors () == n;
+    }
+
+    // Returns whether 'n' is deficient (less than the sum of its proper factors).
+    bool IsDeficient () const
+    {
+        return SumProperFactors () < n;
+    }
+
+    // Returns whether 'n' is abundant (greater than the sum of its proper factors).
+    bool IsAbundant () const
+    {
+        return SumProperFactors () > n;
+    }
+};
+
+// A thread-safe memo of CompactFactorization objects keyed by the integer factored,
+// for workloads that query the same integers repeatedly.
+// Once 'maximumEntries' factorizations are held, further ones are computed but not stored.
+class FactorizationMemo
+{
+private:
+    // The memoized factorizations.
+    std::unordered_map<std::uint64_t, CompactFactorization> factorizations;
+
+    // The maximum number of factorizations held.
+    std::size_t maximumEntries;
+
+    // Guards 'factorizations'.
+    mutable std::mutex factorizationsMutex;
+
+public:
+    // Constructs an empty FactorizationMemo holding at most 'maximumEntries' factorizations.
+    FactorizationMemo (std::size_t maximumEntries = std::size_t (1) << 20);
+
+    // Returns the factorization of 'n', factoring it only if it is not already held.
+    CompactFactorization Get (std::uint64_t n);
+
+    // Returns the number of factorizations held.
+    std::size_t Size () const;
+
+    // Discards every factorization.
+    void Clear ();
+};
@@ -1,18 +1,24 @@
 #pragma once
 
+#include <algorithm>
 #include <cstddef>
 #include <concepts>
+#include <cstdint>
 #include <iostream>
 #include <memory>
 #include <vector>
 
 #include "BitArray.h"
+#include "Presieve.h"
 
 // An Eratosthenes-type sieve to return all numbers in a given range coprime to a given list of obstructions.
 template<std::unsigned_integral T>
 class CoprimeSieve
 {
 private:
+    // The largest period, in words, of the presieve pattern built from the smallest obstructions.
+    static constexpr std::uint64_t maximumPresievePeriod = 1 << 14;
+
     // The underlying bit array.
     BitArray sieve;
 
@@ -43,32 +49,55 @@ public:
         sieve (upperLimit - lowerLimit, true),
         obstructions (obstructions)
     {
-        if (verbose)
-            for (T obstruction : obstructions)
-            {
-                std::clog << "Striking out multiples of " << obstruction << "\n";
+        // Obstructions small enough to share a presieve pattern are stamped over the whole range at once,
+        // provided the range spans enough periods of the pattern to repay building it.
+        std::vector<std::uint64_t> presieved;
+        std::vector<bool> isPresieved (obstructions->size (), false);
+        std::uint64_t period = 1;
 
-                // Sieve out every multiple of 'obstruction' in the range ['lowerLimit', 'upperLimit').
-                T firstMultiple = ((lowerLimit + obstruction - 1) / obstruction) * obstruction;
+        for (std::size_t i = 0; i < obstructions->size (); ++i)
+        {
+            T obstruction = (*obstructions)[i];
 
-                for (T multiple = firstMultiple; multiple < upperLimit; multiple += obstruction)
-                    sieve.Reset (multiple - lowerLimit);
+            if (obstruction > 1 && period * obstruction <= maximumPresievePeriod)
+            {
+                presieved.emplace_back (obstruction);
+                isPresieved[i] = true;
+                period *= obstruction;
             }
+        }
+
+        if (presieved.size () > 1 && sieve.Count () / 64 >= 4 * period)
+        {
+            if (verbose)
+                std::clog << "Presieving multiples of " << presieved.size () << " obstructions\n";
+
+            PresievePattern (presieved, lowerLimit, 1).Apply (sieve, 0, sieve.Count (), 0);
+        }
         else
-            for (T obstruction : obstructions)
-            {
-                T firstMultiple = ((lowerLimit + obstruction - 1) / obstruction) * obstruction;
+            std::fill (isPresieved.begin (), isPresieved.end (), false);
 
-                // Sieve out every multiple of 'obstruction' in the range ['lowerLimit', 'upperLimit').
-                for (T multiple = firstMultiple; multiple < upperLimit; multiple += obstruction)
-                    sieve.Reset (multiple - lowerLimit);
-            }
+        for (std::size_t i = 0; i < obstructions->size (); ++i)
+        {
+            if (isPresieved[i])
+                continue;
+
+            T obstruction = (*obstructions)[i];
+
+            if (verbose)
+                std::clog << "Striking out multiples of " << obstruction << "\n";
+
+            // Sieve out every multiple of 'obstruction' in the range ['lowerLimit', 'upperLimit').
+            T firstMultiple = ((lowerLimit + obstruction - 1) / obstruction) * obstruction;
+            sieve.ResetStride (firstMultiple - lowerLimit, upperLimit - lowerLimit, obstruction);
+        }
 
         coprimes = std::make_shared<std::vector<T>> ();
+        coprimes->reserve (sieve.CountSet ());
 
-        for (T i = lowerLimit; i < upperLimit; ++i)
-            if (sieve.Get (i - lowerLimit))
-                coprimes->emplace_back (i);
+        // Collect the survivors a word at a time.
+        for (T i = sieve.FindNextSet (0); i < upperLimit - lowerLimit; i = sieve.FindNextSet (i + 1))
+            coprimes->emplace_back (lowerLimit + i);
     }
 
     // Returns the numbers in ['lowerLimit', 'upperLimit') coprime to every element of 'obstructions'.
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <algorithm>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "PrimePower.h"
+
+// The narrowest type holding the number of factors of any integer of type 'T';
+// no integer below 2^32 has more than 1920 factors, and none below 2^64 more than 103680.
+template<std::unsigned_integral T>
+using factor_count_t = std::conditional_t<sizeof (T) <= sizeof (std::uint32_t), std::uint16_t, std::uint32_t>;
+
+// Writes into 'factors' the factors of the integer with prime factorization 'primeFactors', in increasing order,
+// using 'buffer' as scratch space.
+// Both vectors are overwritten, and may be reused across calls so that their storage is only allocated once.
+// 'primeFactors' may be any sequence of PrimePower, such as a std::vector or a PrimeFactorsBuffer.
+template<std::unsigned_integral T, typename Container>
+void GenerateFactors (const Container& primeFactors, std::vector<T>& factors, std::vector<T>& buffer)
+{
+    std::size_t numberFactors = 1;
+
+    // Standard product form of divisor counting function.
+    for (const auto& primePower : primeFactors)
+        numberFactors *= primePower.power + 1;
+
+    factors.clear ();
+    factors.reserve (numberFactors);
+    buffer.reserve (numberFactors);
+    factors.emplace_back (1);
+
+    // For each prime power 'prime'^'power' in turn, the factors found so far form a sorted run,
+    // and multiplying it by 'prime', 'prime'^2, ..., 'prime'^'power' appends 'power' further sorted runs of equal length.
+    // Bottom-up merging of adjacent runs then restores increasing order without a general sort.
+    for (const auto& primePower : primeFactors)
+    {
+        std::size_t runSize = factors.size ();
+
+        for (std::size_t i = 0; i < runSize * primePower.power; ++i)
+            factors.emplace_back (factors[i] * T (primePower.prime));
+
+        std::size_t size = factors.size ();
+        buffer.resize (size);
+
+        for (std::size_t width = runSize; width < size; width *= 2)
+        {
+            for (std::size_t start = 0; start < size; start += 2 * width)
+            {
+                std::size_t middle = std::min (start + width, size);
+                std::size_t end = std::min (start + 2 * width, size);
+
+                std::merge
+                (
+                    factors.cbegin () + start, factors.cbegin () + middle,
+                    factors.cbegin () + middle, factors.cbegin () + end,
+                    buffer.begin () + start
+                );
+            }
+
+            std::swap (factors, buffer);
+        }
+    }
+}
+
+// Returns the factors of the integer with prime factorization 'primeFactors', in increasing order.
+template<std::unsigned_integral T>
+std::vector<T> GenerateFactors (const std::vector<PrimePower<T, std::uint32_t>>& primeFactors)
+{
+    std::vector<T> factors;
+    std::vector<T> buffer;
+    GenerateFactors (primeFactors, factors, buffer);
+    return factors;
+}
@@ -1,5 +1,6 @@
 #include "Exponent.h"
 
+#include <cmath>
 #include <cstdint>
 
 std::uint64_t IntegerPow (std::uint64_t base, std::uint64_t exponent)
@@ -19,6 +20,38 @@ std::uint64_t IntegerPow (std::uint64_t base, std::uint64_t exponent)
     return power;
 }
 
+// Computes 'base' to the power 'exponent' into 'power' for unsigned 'TInteger', returning false on overflow.
+template<typename TInteger>
+static bool CheckedPow (TInteger base, std::uint64_t exponent, TInteger& power)
+{
+    // Standard binary exponential algorithm, squaring only while bits of 'exponent' remain.
+    power = 1;
+
+    while (true)
+    {
+        if ((exponent & 1) && __builtin_mul_overflow (power, base, &power))
+            return false;
+
+        exponent /= 2;
+
+        if (exponent == 0)
+            return true;
+
+        if (__builtin_mul_overflow (base, base, &base))
+            return false;
+    }
+}
+
+bool CheckedIntegerPow (std::uint64_t base, std::uint64_t exponent, std::uint64_t& power)
+{
+    return CheckedPow (base, exponent, power);
+}
+
+bool CheckedIntegerPow (std::uint64_t base, std::uint64_t exponent, unsigned __int128& power)
+{
+    return CheckedPow (static_cast<unsigned __int128> (base), exponent, power);
+}
+
 double DoublePow (double base, std::uint64_t exponent)
 {
     // Standard binary exponentiation algorithm.
@@ -35,3 +68,46 @@ double DoublePow (double base, std::uint64_t exponent)
 
     return power;
 }
+
+std::uint64_t IntegerSqrt (std::uint64_t n)
+{
+    // The floating point square root is within one of the exact result, so correct it in both directions.
+    std::uint64_t root = std::sqrt (double (n));
+
+    while (root > 0 && root > n / root)
+        --root;
+
+    while ((root + 1) <= n / (root + 1))
+        ++root;
+
+    return root;
+}
+
+// Returns whether 'base' to the power 'exponent' does not exceed 'n', without overflowing.
+static bool PowerAtMost (std::uint64_t base, std::uint64_t exponent, std::uint64_t n)
+{
+    std::uint64_t power = 1;
+
+    for (std::uint64_t i = 0; i < exponent; ++i)
+        if (__builtin_mul_overflow (power, base, &power) || power > n)
+            return false;
+
+    return true;
+}
+
+std::uint64_t IntegerRoot (std::uint64_t n, std::uint64_t k)
+{
+    if (k == 1)
+        return n;
+
+    // The floating point root is within one or two of the exact result, so correct it in both directions.
+    std::uint64_t root = std::pow (double (n), 1.0 / k);
+
+    while (root > 0 && !PowerAtMost (root, k, n))
+        --root;
+
+    while (PowerAtMost (root + 1, k, n))
+        ++root;
+
+    return root;
+}
@@ -6,6 +6,21 @@
 // Out of range arguments result in undefined behaviour.
 std::uint64_t IntegerPow (std::uint64_t base, std::uint64_t exponent);
 
+// Computes 'base' to the power 'exponent' into 'power' and returns true if the result fits in a 'std::uint64_t',
+// or returns false leaving 'power' unspecified otherwise.
+bool CheckedIntegerPow (std::uint64_t base, std::uint64_t exponent, std::uint64_t& power);
+
+// Computes 'base' to the power 'exponent' into 'power' and returns true if the result fits in an
+// 'unsigned __int128', or returns false leaving 'power' unspecified otherwise.
+bool CheckedIntegerPow (std::uint64_t base, std::uint64_t exponent, unsigned __int128& power);
+
 // Computes 'base' to the power 'exponent' using a binary exponentiation algorithm if the result fits in a 'double'.
 // Out of range arguments result in undefined behaviour.
 double DoublePow (double base, std::uint64_t exponent);
+
+// Returns the greatest integer whose square does not exceed 'n'.
+std::uint64_t IntegerSqrt (std::uint64_t n);
+
+// Returns the greatest integer whose 'k'-th power does not exceed 'n'.
+// 'k' must be positive.
+std::uint64_t IntegerRoot (std::uint64_t n, std::uint64_t k);
@@ -1,22 +1,25 @@
 #pragma once
 
-#include <algorithm>
-#include <cstddef>
 #include <concepts>
 #include <cstdint>
 #include <iostream>
 #include <vector>
 
-#include "Exponent.h"
+#include "Divisors.h"
 #include "PrimePower.h"
 
-// A Eratosthenes-type sieve for computing the least prime factor for a range of positive integers.
+// A linear sieve for computing the least prime factor for a range of positive integers.
 template<std::unsigned_integral T>
 class FactorSieve
 {
 private:
-    // The underlying lookup table.
-    std::vector<T> sieve;
+    // The number of integers between progress reports.
+    static constexpr T reportInterval = T (1) << 24;
+
+    // The underlying lookup table, holding the least prime factor of each composite and 0 for each prime.
+    // The least prime factor of a composite below 'limit' is below the square root of 'limit',
+    // so 32 bits suffice whatever 'T' is.
+    std::vector<std::uint32_t> sieve;
 
     // The exclusive upper bound on the lookup table.
     T limit;
@@ -24,55 +27,45 @@ private:
 public:
     // Constructs a FactorSieve over [0, 'limit') and optionally outputs progress to 'clog'.
     FactorSieve (T limit, bool verbose = false)
-        : limit (limit)
+        : sieve (limit, 0),
+        limit (limit)
     {
-        // Fill the sieve with the integers in [0, 'limit').
-        for (T i = 0; i < limit; ++i)
-            sieve.emplace_back (i);
+        // Gries-Misra linear sieve algorithm: each composite 'i' * 'prime' is written exactly once,
+        // by the least prime factor 'prime', as 'i' runs over the integers and 'prime' over the primes
+        // not exceeding the least prime factor of 'i'.
+        // Only primes below the square root of 'limit' ever take part in a product below 'limit'.
+        std::vector<std::uint32_t> primes;
+
+        for (T i = 2; i < limit; ++i)
+        {
+            if (verbose && i % reportInterval == 0)
+                std::clog << "Sieving from " << i << "\n";
 
-        T prime = 2;
+            T leastPrimeFactor = sieve[i];
 
-        if (verbose)
-            while (prime * prime < limit)
+            if (leastPrimeFactor == 0)
             {
-                std::clog << "Marking multiples of " << prime << "\n";
-
-                // For each 'multiple' of 'prime', if a smaller prime factor of 'multiple' has not been discovered,
-                // mark 'prime' as the smallest prime factor of 'multiple'.
-                for (T multiple = prime * prime; multiple < limit; multiple += prime)
-                    sieve[multiple] = std::min (sieve[multiple], prime);
-
-                // Find the next prime to continue the sieve operation.
-                for (T i = prime + 1; ; ++i)
-                    if (sieve[i] == i)
-                    {
-                        prime = i;
-                        break;
-                    }
+                leastPrimeFactor = i;
+
+                if (i <= (limit - 1) / i)
+                    primes.emplace_back (i);
             }
-        else
-            // For each 'multiple' of 'prime', if a smaller prime factor of 'multiple' has not been discovered,
-            // mark 'prime' as the smallest prime factor of 'multiple'.
-            while (prime * prime < limit)
+
+            for (std::uint32_t prime : primes)
             {
-                for (T multiple = prime * prime; multiple < limit; multiple += prime)
-                    sieve[multiple] = std::min (sieve[multiple], prime);
-
-                // Find the next prime to continue the sieve operation.
-                for (T i = prime + 1; ; ++i)
-                    if (sieve[i] == i)
-                    {
-                        prime = i;
-                        break;
-                    }
+                if (prime > leastPrimeFactor || i > (limit - 1) / prime)
+                    break;
+
+                sieve[i * prime] = prime;
             }
+        }
     }
 
     // Returns the least prime factor of 'n', if 'n' is in [0, 'limit').
     // Out of range arguments result in undefined behaviour.
     T LeastPrimeFactor (T n) const
     {
-        return sieve[n];
+        return sieve[n] == 0 ? n : sieve[n];
     }
 
     // Returns the prime factorization of 'n', if 'n' is in [0, 'limit').
@@ -80,64 +73,54 @@ public:
     std::vector<PrimePower<T, std::uint32_t>> PrimeFactors (T n) const
     {
         std::vector<PrimePower<T, std::uint32_t>> primeFactors;
+        PrimeFactors (n, primeFactors);
+        return primeFactors;
+    }
+
+    // Writes into 'primeFactors' the prime factorization of 'n', if 'n' is in [0, 'limit').
+    // 'primeFactors' is cleared first, and may be any container with 'clear', 'emplace_back' and 'back',
+    // such as a reused std::vector or a PrimeFactorsBuffer, so that no allocation takes place.
+    // Out of range arguments result in undefined behaviour.
+    template<typename Container>
+    void PrimeFactors (T n, Container& primeFactors) const
+    {
+        primeFactors.clear ();
 
         // Repeatedly divide 'n' by the smallest prime dividing 'n',
         // then look up the new smallest prime dividing the result.
-        T prime = sieve[n];
+        T prime = LeastPrimeFactor (n);
         primeFactors.emplace_back (prime, 1);
         n /= prime;
 
         while (n != 1)
         {
-            prime = sieve[n];
+            prime = LeastPrimeFactor (n);
 
             // Check if the prime has already occurred (divides the original 'n' with multiplicity).
-            if (prime == primeFactors[primeFactors.size () - 1].prime)
-                ++(primeFactors[primeFactors.size () - 1].power);
+            if (prime == primeFactors.back ().prime)
+                ++(primeFactors.back ().power);
             else
                 primeFactors.emplace_back (prime, 1);
 
             n /= prime;
         }
-
-        return primeFactors;
     }
 
     // Returns the factors of 'n' in increasing order, if 'n' is in [0, 'limit').
     // Out of range arguments result in undefined behaviour.
     std::vector<T> Factors (T n) const
     {
-        std::vector<T> factors;
-        auto primeFactors = PrimeFactors (n);
-        std::size_t addressSize = primeFactors.size ();
-        std::vector<std::size_t> address (addressSize, 0);
-        std::size_t numberFactors = 1;
-
-        // Standard product form of divisor counting function.
-        for (std::size_t i = 0; i < addressSize; ++i)
-            numberFactors *= (primeFactors[i].power + 1);
-
-        // Iterate through all possible exponent tuples on the primes dividing 'n'.
-        for (std::size_t i = 0; i < numberFactors; ++i)
-        {
-            T factor = 1;
-
-            for (std::size_t j = 0; j < addressSize; ++j)
-                factor *= IntegerPow (std::uint64_t (primeFactors[j].prime), address[j]);
-
-            factors.emplace_back (factor);
-
-            // Move to the next exponent tuple in lex order.
-            for (std::size_t j = 0; j < addressSize; ++j)
-            {
-                address[j] = (address[j] + 1) % (primeFactors[j].power + 1);
-
-                if (address[j] > 0)
-                    break;
-            }
-        }
+        return GenerateFactors (PrimeFactors (n));
+    }
 
-        std::sort (factors.begin (), factors.end ());
-        return factors;
+    // Writes into 'factors' the factors of 'n' in increasing order, if 'n' is in [0, 'limit'),
+    // using 'buffer' as scratch space.
+    // Both vectors may be reused across calls so that their storage is only allocated once.
+    // Out of range arguments result in undefined behaviour.
+    void Factors (T n, std::vector<T>& factors, std::vector<T>& buffer) const
+    {
+        PrimeFactorsBuffer<T> primeFactors;
+        PrimeFactors (n, primeFactors);
+        GenerateFactors (primeFactors, factors, buffer);
     }
 };
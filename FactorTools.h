@@ -1,15 +1,29 @@
 #pragma once
 
+#include "ArithmeticFunctions.h"
 #include "BitArray.h"
 #include "BoundedFactorizations.h"
 #include "BoundedPrimeFixedSizeSets.h"
 #include "BoundedPrimeSetProducts.h"
 #include "BoundedPrimeSets.h"
+#include "CompactFactorization.h"
 #include "CoprimeSieve.h"
+#include "Divisors.h"
 #include "Exponent.h"
 #include "Factorization.h"
 #include "FactorSieve.h"
+#include "FixedVector.h"
+#include "Montgomery.h"
+#include "MultiplicativeFunctionSieve.h"
+#include "PollardRho.h"
+#include "Presieve.h"
 #include "PrimeCount.h"
+#include "PrimePool.h"
 #include "PrimePower.h"
 #include "PrimeSieve.h"
+#include "PrimeSieveCache.h"
 #include "PrimeTest.h"
+#include "RangeFactorization.h"
+#include "SegmentedFactorSieve.h"
+#include "SegmentedPrimeSieve.h"
+#include "SummatoryFunctions.h"
@@ -7,10 +7,16 @@
 #include <cstdint>
 #include <iostream>
 #include <memory>
+#include <mutex>
 #include <numeric>
 #include <vector>
 
+#include <gmpxx.h>
+
+#include "ArithmeticFunctions.h"
+#include "Divisors.h"
 #include "Exponent.h"
+#include "PollardRho.h"
 #include "PrimePower.h"
 #include "PrimeSieve.h"
 
@@ -25,8 +31,18 @@ private:
     // The prime factorization of 'n'.
     std::shared_ptr<std::vector<PrimePower<T, std::uint32_t>>> primeFactors;
 
-    // The factors of 'n' in increasing order.
-    std::shared_ptr<std::vector<T>> factors;
+    // The factors of 'n' in increasing order, generated on the first call to 'Factors ()'.
+    struct LazyFactors
+    {
+        // Guards the generation of 'factors'.
+        std::once_flag flag;
+
+        // The factors.
+        std::vector<T> factors;
+    };
+
+    // The lazily generated factors of 'n', shared between copies.
+    std::shared_ptr<LazyFactors> lazyFactors;
 
     // Computes the prime factors of 'n' and optionally outputs progress to 'clog'.
     void GeneratePrimeFactors (std::shared_ptr<const PrimeSieve<T>> sieve, bool verbose)
@@ -39,7 +55,7 @@ private:
         {
             std::clog << "\n";
 
-            for (T prime : *sieve->Primes ())
+            for (T prime : *sieve)
             {
                 if (prime > sqrt_r)
                     break;
@@ -62,7 +78,7 @@ private:
             }
         }
         else
-            for (T prime : *sieve->Primes ())
+            for (T prime : *sieve)
             {
                 if (prime > sqrt_r)
                     break;
@@ -86,54 +102,35 @@ private:
             primeFactors->emplace_back (r, 1);
     }
 
-    // Computes the factors of 'n'.
-    void GenerateFactors ()
+public:
+    // Constructs a Factorization of 'n' and optionally outputs progress to 'clog'.
+    // Integers of up to 64 bits are factored by trial division by small primes followed by Pollard-Brent rho,
+    // and wider integers by trial division by every prime up to the square root of 'n'.
+    Factorization (T n, bool verbose = false)
+        : n (n),
+        primeFactors (std::make_shared<std::vector<PrimePower<T, std::uint32_t>>> ()),
+        lazyFactors (std::make_shared<LazyFactors> ())
     {
-        std::size_t addressSize = primeFactors->size ();
-        std::vector<std::size_t> address (addressSize, 0);
-        std::size_t numberFactors = 1;
-
-        // Standard product form of divisor counting function.
-        for (std::size_t i = 0; i < addressSize; ++i)
-            numberFactors *= ((*primeFactors)[i].power + 1);
-
-        // Iterate through all possible exponent tuples on the primes dividing 'n'.
-        for (std::size_t i = 0; i < numberFactors; ++i)
+        if constexpr (sizeof (T) <= sizeof (std::uint64_t))
         {
-            T factor = 1;
-
-            for (std::size_t j = 0; j < addressSize; ++j)
-                factor *= IntegerPow ((*primeFactors)[j].prime, address[j]);
-
-            factors->emplace_back (factor);
+            if (verbose)
+                std::clog << "\nFactoring by Pollard-Brent rho\n";
 
-            // Move to the next exponent tuple in lex order.
-            for (std::size_t j = 0; j < addressSize; ++j)
-            {
-                address[j] = (address[j] + 1) % ((*primeFactors)[j].power + 1);
-
-                if (address[j] > 0)
-                    break;
-            }
+            for (const auto& primePower : PollardRhoPrimeFactors (n))
+                primeFactors->emplace_back (T (primePower.prime), primePower.power);
         }
-
-        std::sort (factors->begin (), factors->end ());
+        else
+            GeneratePrimeFactors (std::make_shared<const PrimeSieve<T>> (IntegerSqrt (n) + 1, verbose), verbose);
     }
 
-public:
-    // Constructs a Factorization of 'n' and optionally outputs progress to 'clog'.
-    Factorization (T n, bool verbose = false)
-        : Factorization (n, std::make_shared<const PrimeSieve<T>> (std::sqrt (n), verbose), verbose) {}
-
     // Constructs a Factorization of 'n' using a precomputed list of primes
     // and optionally outputs progress to 'clog'.
     Factorization (T n, std::shared_ptr<const PrimeSieve<T>> sieve, bool verbose = false)
         : n (n),
         primeFactors (std::make_shared<std::vector<PrimePower<T, std::uint32_t>>> ()),
-        factors (std::make_shared<std::vector<T>> ())
+        lazyFactors (std::make_shared<LazyFactors> ())
     {
         GeneratePrimeFactors (sieve, verbose);
-        GenerateFactors ();
     }
 
     // Returns the prime factorization of 'n'.
@@ -151,11 +148,7 @@ public:
     // Returns the 'prime'-adic valuation of 'n'.
     std::uint32_t PAdicValuation (T prime) const
     {
-        for (const auto& primePower : *primeFactors)
-            if (primePower.prime == prime)
-                return primePower.power;
-
-        return 0;
+        return ::PAdicValuation (*primeFactors, prime);
     }
 
     // Returns the 'prime'-adic valuation of 'n'.
@@ -173,24 +166,30 @@ public:
     // Returns the number of prime factors of 'n' with multiplicity.
     std::size_t BigOmega () const
     {
-        std::size_t sum = 0;
-
-        for (const auto& primePower : *primeFactors)
-            sum += primePower.power;
-
-        return sum;
+        return ::BigOmega (*primeFactors);
     }
 
     // Returns the factors of 'n' in increasing order.
+    // The list is generated on the first call and occupies memory proportional to the number of factors;
+    // the divisor functions below are evaluated from the prime factorization instead.
     std::shared_ptr<const std::vector<T>> Factors () const
     {
-        return factors;
+        std::call_once
+        (
+            lazyFactors->flag,
+            [this] ()
+            {
+                lazyFactors->factors = GenerateFactors (*primeFactors);
+            }
+        );
+
+        return std::shared_ptr<const std::vector<T>> (lazyFactors, &lazyFactors->factors);
     }
 
     // Returns the number of factors of 'n'.
     std::size_t FactorsCount () const
     {
-        return factors->size ();
+        return ::FactorsCount (*primeFactors);
     }
 
     // Returns the number of factors of 'n'.
@@ -199,44 +198,43 @@ public:
         return FactorsCount ();
     }
 
-    // Returns the sum of the proper factors of 'n'.
+    // Returns the sum of the proper factors of 'n', modulo 2^64.
     std::uint64_t SumProperFactors () const
     {
-        std::uint64_t sum = 0;
-
-        for (auto factor = factors->cbegin (); factor != factors->cend () - 1; ++factor)
-            sum += (*factor);
-
-        return sum;
+        return Sigma1 () - n;
     }
 
-    // Returns the sum of the divisors of 'n'.
+    // Returns the sum of the divisors of 'n', modulo 2^64.
     std::uint64_t Sigma1 () const
     {
-        return SumProperFactors () + n;
+        return SigmaK (1);
     }
 
-    // Returns the sum of the 'k'-th powers of the divisors of 'n'.
+    // Returns the sum of the 'k'-th powers of the divisors of 'n', modulo 2^64.
+    // Use 'TrySigmaK' or 'ExactSigmaK' where the sum may not fit.
     std::uint64_t SigmaK (std::uint64_t k) const
     {
-        std::uint64_t sum = 0;
+        return ::SigmaK (*primeFactors, k);
+    }
 
-        for (T factor : *factors)
-            sum += IntegerPow (factor, k);
+    // Computes the sum of the 'k'-th powers of the divisors of 'n' into 'sigma' and returns true if it fits in an
+    // 'unsigned __int128', or returns false leaving 'sigma' unspecified otherwise.
+    bool TrySigmaK (std::uint64_t k, unsigned __int128& sigma) const
+    {
+        return ::TrySigmaK (*primeFactors, k, sigma);
+    }
 
-        return sum;
+    // Returns the sum of the 'k'-th powers of the divisors of 'n' exactly.
+    // The sum is computed in 128-bit arithmetic, falling back to arbitrary precision only if that overflows.
+    mpz_class ExactSigmaK (std::uint64_t k) const
+    {
+        return ::ExactSigmaK (*primeFactors, k);
     }
 
     // Returns the number of integers in [0, 'n') coprime to 'n'.
     T Totient () const
     {
-        // Standard product representation of totient function.
-        T totient = n;
-
-        for (const auto& primePower : *primeFactors)
-            totient = (totient / primePower.prime) * (primePower.prime - 1);
-
-        return totient;
+        return ::Totient (n, *primeFactors);
     }
 
     // Returns the number of integers in [0, 'n') coprime to 'n'.
@@ -248,23 +246,13 @@ public:
     // Returns the radical of 'n'.
     T Radical () const
     {
-        T radical = 1;
-
-        for (const auto& primePower : *primeFactors)
-            radical *= primePower.prime;
-
-        return radical;
+        return ::Radical<T> (*primeFactors);
     }
 
     // Returns 0 if 'n' is not squarefree, 1 if 'n' has an even number of prime factors, and -1 otherwise.
     std::int32_t MoebiusFunction () const
     {
-        for (const auto& primePower : *primeFactors)
-            if (primePower.power > 1)
-                return 0;
-
-        // Efficient (-1)^n algorithm.
-        return (-(primeFactors->size () & 1)) | 1;
+        return ::MoebiusFunction (*primeFactors);
     }
 
     // Returns 0 if 'n' is not squarefree, 1 if 'n' has an even number of prime factors, and -1 otherwise.
@@ -276,55 +264,19 @@ public:
     // Returns -1 to the power of 'BigOmega ()'.
     std::int32_t LiouvilleFunction () const
     {
-        // Efficient (-1)^n algorithm.
-        return (-(BigOmega () & 1)) | 1;
+        return ::LiouvilleFunction (*primeFactors);
     }
 
     // Returns -1 to the power of 'BigOmega ()'.
     std::int32_t SmallLambda () const
     {
-        // Efficient (-1)^n algorithm.
-        return (-(BigOmega () & 1)) | 1;
+        return LiouvilleFunction ();
     }
 
     // Returns the least common multiple of the multiplicative orders of the integers in [0, 'n') coprime to 'n'.
     T CarmichaelFunction () const
     {
-        // Standard product representation of Carmichael function.
-        if (n == 1)
-            return 1;
-
-        T exponent;
-
-        if ((*primeFactors)[0].prime == 2)
-        {
-            if ((*primeFactors)[0].power == 1)
-                exponent = 1;
-            else if ((*primeFactors)[0].power == 2)
-                exponent = 2;
-            else
-                exponent = IntegerPow (2, (*primeFactors)[0].power - 2);
-
-            for (auto primePower = primeFactors->cbegin () + 1; primePower != primeFactors->cend (); ++primePower)
-                exponent = std::lcm
-                (
-                    exponent,
-                    IntegerPow (primePower->prime, primePower->power - 1) * (primePower->prime - 1)
-                );
-        }
-        else
-        {
-            exponent = 1;
-
-            for (const auto& primePower : *primeFactors)
-                exponent = std::lcm
-                (
-                    exponent,
-                    IntegerPow (primePower.prime, primePower.power - 1) * (primePower.prime - 1)
-                );
-        }
-
-        return exponent;
+        return ::CarmichaelFunction (n, *primeFactors);
     }
 
     // Returns the greatest common divisor of 'n' and 'other.n'.
@@ -342,13 +294,13 @@ public:
     // Returns whether 'n' is prime.
     bool IsPrime () const
     {
-        return FactorsCount () == 2;
+        return primeFactors->size () == 1 && (*primeFactors)[0].power == 1;
     }
 
     // Returns whether 'n' is composite.
     bool IsComposite () const
     {
-        return FactorsCount () > 2;
+        return BigOmega () > 1;
     }
 
     // Returns whether 'n' is coprime to 'other.n'.
@@ -360,11 +312,7 @@ public:
     // Returns whether 'n' is 'h'-free; that is, whether no 'h'-th power divides 'n'.
     bool IsHFree (std::uint32_t h) const
     {
-        for (const auto& primePower : *primeFactors)
-            if (primePower.power >= h)
-                return false;
-
-        return true;
+        return ::IsHFree (*primeFactors, h);
     }
 
     // Returns whether 'n' is squarefree.
@@ -0,0 +1,108 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <utility>
+
+// A vector with fixed capacity stored inline, for short lists built in inner loops without touching the heap.
+// Exceeding the capacity results in undefined behaviour.
+template<typename T, std::size_t Capacity>
+class FixedVector
+{
+private:
+    // The underlying storage, of which the first 'count' elements are in use.
+    std::array<T, Capacity> storage;
+
+    // The number of elements in use.
+    std::size_t count;
+
+public:
+    // Constructs an empty FixedVector.
+    FixedVector ()
+        : count (0) {}
+
+    // Constructs an element in place at the end of the vector.
+    template<typename... Args>
+    T& emplace_back (Args&&... args)
+    {
+        storage[count] = T (std::forward<Args> (args)...);
+        return storage[count++];
+    }
+
+    // Removes the last element.
+    // Calling this on an empty vector results in undefined behaviour.
+    void pop_back ()
+    {
+        --count;
+    }
+
+    // Removes every element.
+    void clear ()
+    {
+        count = 0;
+    }
+
+    // Returns the number of elements.
+    std::size_t size () const
+    {
+        return count;
+    }
+
+    // Returns whether there are no elements.
+    bool empty () const
+    {
+        return count == 0;
+    }
+
+    // Returns the maximum number of elements.
+    static constexpr std::size_t capacity ()
+    {
+        return Capacity;
+    }
+
+    // Returns the element at a given index.
+    // Out of range indices result in undefined behaviour.
+    T& operator[] (std::size_t index)
+    {
+        return storage[index];
+    }
+
+    const T& operator[] (std::size_t index) const
+    {
+        return storage[index];
+    }
+
+    // Returns the last element.
+    // Calling this on an empty vector results in undefined behaviour.
+    T& back ()
+    {
+        return storage[count - 1];
+    }
+
+    const T& back () const
+    {
+        return storage[count - 1];
+    }
+
+    // Returns a pointer to the first element.
+    T* begin ()
+    {
+        return storage.data ();
+    }
+
+    // Returns a pointer past the last element.
+    T* end ()
+    {
+        return storage.data () + count;
+    }
+
+    const T* begin () const
+    {
+        return storage.data ();
+    }
+
+    const T* end () const
+    {
+        return storage.data () + count;
+    }
+};
@@ -2,6 +2,7 @@
 #include <cstdint>
 #include <iostream>
 #include <memory>
+#include <thread>
 #include <vector>
 
 #include <gmpxx.h>
@@ -15,6 +16,7 @@
 #include "PrimePower.h"
 #include "PrimeSieve.h"
 #include "PrimeTest.h"
+#include "SummatoryFunctions.h"
 
 int main ()
 {
@@ -39,7 +41,7 @@ int main ()
             std::cout << "Limit: ";
             std::cin >> limit;
             std::cout << "\n";
-            PrimeSieve sieve (limit, true);
+            PrimeSieve sieve (limit, true, std::thread::hardware_concurrency ());
             std::size_t count = sieve.Count ();
             std::cout << "Found " << count << " primes less than " << limit << "\n\n";
 
@@ -112,11 +114,15 @@ int main ()
             std::cout << "n: ";
             std::cin >> n;
             std::cout << "\n";
-            PrimeSieve sieve (n, false);
+            PrimeSieve sieve (n, false, std::thread::hardware_concurrency ());
             std::cout
                 << "Found " << sieve.Count () << " primes less than " << n << "\n"
+                << "Meissel-Lehmer count: " << (n == 0 ? 0 : PrimePiExact (n - 1, std::thread::hardware_concurrency ()))
+                << " primes less than " << n << "\n"
                 << "Legendre estimate: " << LegendreCount (n) << " primes less than " << n << "\n"
-                << "Logarithmic integral estimate: " << LiCount (n) << " primes less than " << n << "\n\n";
+                << "Logarithmic integral estimate: " << LiCount (n) << " primes less than " << n << "\n"
+                << "M(n): " << Mertens (n, std::thread::hardware_concurrency ()) << "\n"
+                << "L(n): " << SummatoryLiouville (n, std::thread::hardware_concurrency ()) << "\n\n";
         }
         else if (c == '4')
         {
@@ -132,26 +138,30 @@ int main ()
                 std::uint64_t limit;
                 std::cout << "Limit: ";
                 std::cin >> limit;
-                std::cout
-                    << "\n"
-                    << "1 = (empty product)\n"
-                    << "mu(1) = 1\n";
-                BoundedPrimeSetIterator bpsi (limit);
-                std::size_t counter = 1;
+                std::cout << "\n";
+                std::size_t counter = 0;
 
-                for (++bpsi; !bpsi.IsEnd (); ++bpsi)
-                {
-                    auto primes = bpsi.Primes ();
-                    std::cout << bpsi.N () << " = " << (*primes)[0];
+                ForEachBoundedPrimeSet
+                (
+                    limit,
+                    [&counter] (std::uint64_t n, primes_span_t primes, std::int32_t mu)
+                    {
+                        if (primes.empty ())
+                            std::cout << "1 = (empty product)\n";
+                        else
+                        {
+                            std::cout << n << " = " << primes[0];
 
-                    for (auto prime = primes->cbegin () + 1; prime != primes->cend (); ++prime)
-                        std::cout << " * " << *prime;
+                            for (auto prime = primes.begin () + 1; prime != primes.end (); ++prime)
+                                std::cout << " * " << *prime;
 
-                    std::cout
-                        << "\n"
-                        << "mu(" << bpsi.N () << ") = " << bpsi.MoebiusN () << "\n";
-                    ++counter;
-                }
+                            std::cout << "\n";
+                        }
+
+                        std::cout << "mu(" << n << ") = " << mu << "\n";
+                        ++counter;
+                    }
+                );
 
                 std::cout
                     << "\n"
@@ -167,30 +177,33 @@ int main ()
                 std::cout << "Set size: ";
                 std::cin >> setSize;
                 std::cout << "\n";
+                std::size_t counter = 0;
 
-                if (setSize == 0)
-                    std::cout << "1 = (empty product)\n\n";
-                else
-                {
-                    BoundedPrimeFixedSizeSetIterator bpfssi (limit, setSize);
-                    std::size_t counter = 0;
-
-                    for (; !bpfssi.IsEnd (); ++bpfssi)
+                ForEachBoundedPrimeFixedSizeSet
+                (
+                    limit,
+                    setSize,
+                    [&counter] (std::uint64_t n, primes_span_t primes)
                     {
-                        auto primes = bpfssi.Primes ();
-                        std::cout << bpfssi.N () << " = " << (*primes)[0];
+                        if (primes.empty ())
+                            std::cout << "1 = (empty product)\n";
+                        else
+                        {
+                            std::cout << n << " = " << primes[0];
 
-                        for (auto prime = primes->cbegin () + 1; prime != primes->cend (); ++prime)
-                            std::cout << " * " << *prime;
+                            for (auto prime = primes.begin () + 1; prime != primes.end (); ++prime)
+                                std::cout << " * " << *prime;
+
+                            std::cout << "\n";
+                        }
 
-                        std::cout << "\n";
                         ++counter;
                     }
+                );
 
-                    std::cout
-                        << "\n"
-                        << "Counted " << counter << " fixed-size prime sets.\n\n";
-                }
+                std::cout
+                    << "\n"
+                    << "Counted " << counter << " fixed-size prime sets.\n\n";
             }
             else if (c == '3')
             {
@@ -198,33 +211,39 @@ int main ()
                 std::cout << "Limit: ";
                 std::cin >> limit;
                 std::cout << "\n";
-                BoundedFactorizationIterator bfi (limit);
-                std::cout << "1 = (empty product)\n";
-                std::size_t counter = 1;
+                std::size_t counter = 0;
 
-                for (++bfi; !bfi.IsEnd (); ++bfi)
-                {
-                    auto factorization = bfi.Factorization ();
-                    std::cout << bfi.N () << " = " << (*factorization)[0].prime;
+                ForEachBoundedFactorization
+                (
+                    limit,
+                    [&counter] (std::uint64_t n, factorization_span_t factorization, std::int32_t mu)
+                    {
+                        if (factorization.empty ())
+                            std::cout << "1 = (empty product)\n";
+                        else
+                        {
+                            std::cout << n << " = " << factorization[0].prime;
 
-                    if ((*factorization)[0].power > 1)
-                        std::cout << "^" << (*factorization)[0].power;
+                            if (factorization[0].power > 1)
+                                std::cout << "^" << factorization[0].power;
 
-                    for (auto primePower = factorization->cbegin () + 1;
-                        primePower != factorization->cend ();
-                        ++primePower)
-                    {
-                        std::cout << " * " << primePower->prime;
+                            for (auto primePower = factorization.begin () + 1;
+                                primePower != factorization.end ();
+                                ++primePower)
+                            {
+                                std::cout << " * " << primePower->prime;
 
-                        if (primePower->power > 1)
-                            std::cout << "^" << primePower->power;
-                    }
+                                if (primePower->power > 1)
+                                    std::cout << "^" << primePower->power;
+                            }
 
-                    std::cout
-                        << "\n"
-                        << "mu(" << bfi.N () << ") = " << bfi.MoebiusN () << "\n";
-                    ++counter;
-                }
+                            std::cout << "\n";
+                        }
+
+                        std::cout << "mu(" << n << ") = " << mu << "\n";
+                        ++counter;
+                    }
+                );
 
                 std::cout
                     << "\n"
@@ -0,0 +1,108 @@
+#pragma once
+
+#include <cstdint>
+
+// Arithmetic modulo a fixed odd 64-bit modulus in Montgomery form, where the residue 'a' is represented by
+// 'a' * 2^64 modulo the modulus.
+// Multiplication then needs no division, only two 64 x 64 -> 128 bit multiplications and a subtraction.
+// Every residue passed in or returned is in Montgomery form and less than the modulus unless stated otherwise.
+class Montgomery
+{
+private:
+    // The modulus, which must be odd.
+    std::uint64_t n;
+
+    // The inverse of 'n' modulo 2^64.
+    std::uint64_t nInverse;
+
+    // 2^128 modulo 'n', used to convert into Montgomery form.
+    std::uint64_t r2;
+
+    // 2^64 modulo 'n', the Montgomery form of 1.
+    std::uint64_t one;
+
+public:
+    // Constructs Montgomery arithmetic modulo 'n', which must be odd and greater than 1.
+    explicit Montgomery (std::uint64_t n)
+        : n (n), nInverse (n)
+    {
+        // Newton's iteration doubles the number of correct low bits each time, and 'n' is its own inverse modulo 8.
+        for (int i = 0; i < 5; ++i)
+            nInverse *= 2 - n * nInverse;
+
+        one = -n % n;
+        r2 = static_cast<unsigned __int128> (one) * one % n;
+    }
+
+    // Returns the modulus.
+    std::uint64_t Modulus () const
+    {
+        return n;
+    }
+
+    // Returns the Montgomery form of 1.
+    std::uint64_t One () const
+    {
+        return one;
+    }
+
+    // Returns 't' / 2^64 modulo 'n', for 't' less than 'n' * 2^64.
+    std::uint64_t Reduce (unsigned __int128 t) const
+    {
+        // Subtracting 'm' * 'n' clears the low 64 bits of 't', so only the high halves need subtracting.
+        std::uint64_t m = static_cast<std::uint64_t> (t) * nInverse;
+        std::uint64_t tHigh = static_cast<std::uint64_t> (t >> 64);
+        std::uint64_t mnHigh = static_cast<std::uint64_t> ((static_cast<unsigned __int128> (m) * n) >> 64);
+        return tHigh >= mnHigh ? tHigh - mnHigh : tHigh - mnHigh + n;
+    }
+
+    // Returns the Montgomery form of 'a', which need not be reduced modulo 'n'.
+    std::uint64_t ToMontgomery (std::uint64_t a) const
+    {
+        return Reduce (static_cast<unsigned __int128> (a % n) * r2);
+    }
+
+    // Returns the residue represented by 'a'.
+    std::uint64_t FromMontgomery (std::uint64_t a) const
+    {
+        return Reduce (a);
+    }
+
+    // Returns the product of 'a' and 'b'.
+    std::uint64_t Multiply (std::uint64_t a, std::uint64_t b) const
+    {
+        return Reduce (static_cast<unsigned __int128> (a) * b);
+    }
+
+    // Returns the sum of 'a' and 'b'.
+    std::uint64_t Add (std::uint64_t a, std::uint64_t b) const
+    {
+        // The sum may wrap around 2^64 when 'n' exceeds 2^63.
+        std::uint64_t sum = a + b;
+        return sum >= n || sum < a ? sum - n : sum;
+    }
+
+    // Returns the difference of 'a' and 'b'.
+    std::uint64_t Subtract (std::uint64_t a, std::uint64_t b) const
+    {
+        return a >= b ? a - b : a - b + n;
+    }
+
+    // Returns 'base' to the power 'exponent'.
+    std::uint64_t Power (std::uint64_t base, std::uint64_t exponent) const
+    {
+        // Standard binary exponentiation algorithm.
+        std::uint64_t power = one;
+
+        while (exponent > 0)
+        {
+            if (exponent & 1)
+                power = Multiply (power, base);
+
+            exponent /= 2;
+            base = Multiply (base, base);
+        }
+
+        return power;
+    }
+};
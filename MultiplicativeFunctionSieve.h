@@ -0,0 +1,152 @@
+#pragma once
+
+#include <concepts>
+#include <cstdint>
+#include <iostream>
+#include <vector>
+
+#include "Divisors.h"
+#include "FactorSieve.h"
+
+// Tables of the common arithmetic functions of Factorization for every integer in [0, 'limit'),
+// each stored in the narrowest integer type holding all of its values.
+// Every entry is derived from the entry for 'n' / 'p', where 'p' is the least prime factor of 'n',
+// so one pass in increasing order over a FactorSieve fills every table without factoring anything.
+// For windows far from 0, or to spread the work over several threads, use RangeFactorization.
+template<std::unsigned_integral T>
+class MultiplicativeFunctionSieve
+{
+private:
+    // The exclusive upper bound on the tables.
+    T limit;
+
+    // The number of integers in [0, 'n') coprime to 'n' at index 'n'.
+    std::vector<T> totient;
+
+    // The Moebius function of 'n' at index 'n'.
+    std::vector<std::int8_t> mu;
+
+    // The number of factors of 'n' at index 'n'.
+    std::vector<factor_count_t<T>> tau;
+
+    // The sum of the factors of 'n' modulo 2^64 at index 'n'.
+    std::vector<std::uint64_t> sigma;
+
+    // The Liouville function of 'n' at index 'n'.
+    std::vector<std::int8_t> liouville;
+
+    // The number of distinct prime factors of 'n' at index 'n'.
+    std::vector<std::uint8_t> smallOmega;
+
+    // The number of prime factors of 'n' with multiplicity at index 'n'.
+    std::vector<std::uint8_t> bigOmega;
+
+public:
+    // Constructs a MultiplicativeFunctionSieve over [0, 'limit') and optionally outputs progress to 'clog'.
+    // The entries for 0 are all 0.
+    MultiplicativeFunctionSieve (T limit, bool verbose = false)
+        : limit (limit),
+        totient (limit, 0),
+        mu (limit, 0),
+        tau (limit, 0),
+        sigma (limit, 0),
+        liouville (limit, 0),
+        smallOmega (limit, 0),
+        bigOmega (limit, 0)
+    {
+        if (limit < 2)
+            return;
+
+        FactorSieve<T> factorSieve (limit, verbose);
+
+        if (verbose)
+            std::clog << "Tabulating multiplicative functions\n";
+
+        totient[1] = 1;
+        mu[1] = 1;
+        tau[1] = 1;
+        sigma[1] = 1;
+        liouville[1] = 1;
+
+        // Write 'n' = 'prime' * 'm', where 'prime' is the least prime factor of 'n'.
+        // If 'prime' does not divide 'm', every function is multiplicative across 'prime' and 'm';
+        // otherwise the values for 'm' and 'm' / 'prime' suffice, since for 'm' = 'prime'^'e' * 'r' with 'r' coprime
+        // to 'prime', tau ('n') = 2 tau ('m') - tau ('m' / 'prime') and
+        // sigma ('n') = ('prime' + 1) sigma ('m') - 'prime' sigma ('m' / 'prime').
+        for (T n = 2; n < limit; ++n)
+        {
+            T prime = factorSieve.LeastPrimeFactor (n);
+            T m = n / prime;
+
+            if (m > 1 && factorSieve.LeastPrimeFactor (m) == prime)
+            {
+                totient[n] = totient[m] * prime;
+                mu[n] = 0;
+                tau[n] = 2 * tau[m] - tau[m / prime];
+                sigma[n] = (prime + 1) * sigma[m] - prime * sigma[m / prime];
+                smallOmega[n] = smallOmega[m];
+            }
+            else
+            {
+                totient[n] = totient[m] * (prime - 1);
+                mu[n] = -mu[m];
+                tau[n] = 2 * tau[m];
+                sigma[n] = (prime + 1) * sigma[m];
+                smallOmega[n] = smallOmega[m] + 1;
+            }
+
+            liouville[n] = -liouville[m];
+            bigOmega[n] = bigOmega[m] + 1;
+        }
+    }
+
+    // Returns the number of integers in [0, 'n') coprime to 'n', if 'n' is in [0, 'limit').
+    // Out of range arguments result in undefined behaviour.
+    T Totient (T n) const
+    {
+        return totient[n];
+    }
+
+    // Returns 0 if 'n' is not squarefree, 1 if 'n' has an even number of prime factors, and -1 otherwise,
+    // if 'n' is in [0, 'limit').
+    // Out of range arguments result in undefined behaviour.
+    std::int32_t MoebiusFunction (T n) const
+    {
+        return mu[n];
+    }
+
+    // Returns the number of factors of 'n', if 'n' is in [0, 'limit').
+    // Out of range arguments result in undefined behaviour.
+    factor_count_t<T> Tau (T n) const
+    {
+        return tau[n];
+    }
+
+    // Returns the sum of the factors of 'n' modulo 2^64, if 'n' is in [0, 'limit').
+    // Out of range arguments result in undefined behaviour.
+    std::uint64_t Sigma1 (T n) const
+    {
+        return sigma[n];
+    }
+
+    // Returns -1 to the power of the number of prime factors of 'n' with multiplicity, if 'n' is in [0, 'limit').
+    // Out of range arguments result in undefined behaviour.
+    std::int32_t LiouvilleFunction (T n) const
+    {
+        return liouville[n];
+    }
+
+    // Returns the number of distinct prime factors of 'n', if 'n' is in [0, 'limit').
+    // Out of range arguments result in undefined behaviour.
+    std::uint32_t SmallOmega (T n) const
+    {
+        return smallOmega[n];
+    }
+
+    // Returns the number of prime factors of 'n' with multiplicity, if 'n' is in [0, 'limit').
+    // Out of range arguments result in undefined behaviour.
+    std::uint32_t BigOmega (T n) const
+    {
+        return bigOmega[n];
+    }
+};
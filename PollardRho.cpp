@@ -0,0 +1,146 @@
+#include "PollardRho.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <numeric>
+#include <vector>
+
+#include "Montgomery.h"
+#include "PrimePower.h"
+#include "PrimeSieve.h"
+#include "PrimeTest.h"
+
+// The exclusive upper bound on the primes divided out by trial division before running Pollard-Brent rho.
+static constexpr std::uint32_t smallPrimeLimit = 1 << 10;
+
+// The number of steps of the rho iteration between greatest common divisor computations.
+static constexpr std::uint64_t gcdInterval = 128;
+
+// Returns the primes in [0, 'smallPrimeLimit').
+static const std::vector<std::uint32_t>& SmallPrimes ()
+{
+    static const std::vector<std::uint32_t> smallPrimes = *PrimeSieve<std::uint32_t> (smallPrimeLimit).Primes ();
+    return smallPrimes;
+}
+
+std::uint64_t PollardBrentFactor (std::uint64_t n)
+{
+    Montgomery montgomery (n);
+
+    // Iterate 'x' -> 'x'^2 + 'c' for increasing 'c' until one of them yields a proper factor.
+    for (std::uint64_t c = 1; ; ++c)
+    {
+        std::uint64_t increment = montgomery.ToMontgomery (c);
+        std::uint64_t y = montgomery.ToMontgomery (2);
+        std::uint64_t x = y;
+        std::uint64_t savedY = y;
+        std::uint64_t product = montgomery.One ();
+        std::uint64_t factor = 1;
+
+        // Brent's cycle detection: 'x' is held at the start of each run of 'runLength' steps of 'y',
+        // and the differences 'x' - 'y' are accumulated into 'product' so that only one gcd is taken per
+        // 'gcdInterval' steps.
+        // Montgomery form multiplies every residue by a unit, which leaves the gcd with 'n' unchanged.
+        for (std::uint64_t runLength = 1; factor == 1; runLength *= 2)
+        {
+            x = y;
+
+            for (std::uint64_t i = 0; i < runLength; ++i)
+                y = montgomery.Add (montgomery.Multiply (y, y), increment);
+
+            for (std::uint64_t step = 0; step < runLength && factor == 1; step += gcdInterval)
+            {
+                savedY = y;
+
+                for (std::uint64_t i = 0; i < std::min (gcdInterval, runLength - step); ++i)
+                {
+                    y = montgomery.Add (montgomery.Multiply (y, y), increment);
+                    product = montgomery.Multiply (product, montgomery.Subtract (x, y));
+                }
+
+                factor = std::gcd (product, n);
+            }
+        }
+
+        // The batch overshot into a multiple of 'n', so step through it again one difference at a time.
+        if (factor == n)
+        {
+            do
+            {
+                savedY = montgomery.Add (montgomery.Multiply (savedY, savedY), increment);
+                factor = std::gcd (montgomery.Subtract (x, savedY), n);
+            }
+            while (factor == 1);
+        }
+
+        if (factor != n)
+            return factor;
+    }
+}
+
+// Appends to 'primes' the prime factors of 'n' with multiplicity, in no particular order.
+static void CollectPrimeFactors (std::uint64_t n, std::vector<std::uint64_t>& primes)
+{
+    if (n == 1)
+        return;
+
+    if (IsPrime64 (n))
+    {
+        primes.emplace_back (n);
+        return;
+    }
+
+    std::uint64_t factor = PollardBrentFactor (n);
+    CollectPrimeFactors (factor, primes);
+    CollectPrimeFactors (n / factor, primes);
+}
+
+std::vector<PrimePower<std::uint64_t, std::uint32_t>> PollardRhoPrimeFactors (std::uint64_t n)
+{
+    std::vector<PrimePower<std::uint64_t, std::uint32_t>> primeFactors;
+
+    if (n < 2)
+        return primeFactors;
+
+    // Standard trial factoring algorithm, restricted to small primes.
+    for (std::uint32_t prime : SmallPrimes ())
+    {
+        if (prime > n / prime)
+            break;
+
+        if (n % prime != 0)
+            continue;
+
+        primeFactors.emplace_back (prime, 0);
+
+        while (n % prime == 0)
+        {
+            n /= prime;
+            ++primeFactors.back ().power;
+        }
+    }
+
+    // A cofactor with no prime factor below 'smallPrimeLimit' is prime if it is below 'smallPrimeLimit'^2.
+    if (n < std::uint64_t (smallPrimeLimit) * smallPrimeLimit)
+    {
+        if (n > 1)
+            primeFactors.emplace_back (n, 1);
+
+        return primeFactors;
+    }
+
+    std::vector<std::uint64_t> primes;
+    CollectPrimeFactors (n, primes);
+    std::sort (primes.begin (), primes.end ());
+
+    for (std::uint64_t prime : primes)
+    {
+        if (!primeFactors.empty () && primeFactors.back ().prime == prime)
+            ++primeFactors.back ().power;
+        else
+            primeFactors.emplace_back (prime, 1);
+    }
+
+    return primeFactors;
+}
@@ -0,0 +1,15 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "PrimePower.h"
+
+// Returns a non-trivial factor of 'n' using Brent's variant of Pollard's rho algorithm.
+// 'n' must be an odd composite; any other argument results in undefined behaviour.
+std::uint64_t PollardBrentFactor (std::uint64_t n);
+
+// Returns the prime factorization of 'n' in increasing order of primes, by trial division by small primes
+// followed by Pollard-Brent rho on the remaining cofactor.
+// The prime factorizations of 0 and 1 are empty.
+std::vector<PrimePower<std::uint64_t, std::uint32_t>> PollardRhoPrimeFactors (std::uint64_t n);
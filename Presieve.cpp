@@ -0,0 +1,52 @@
+#include "Presieve.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "BitArray.h"
+
+PresievePattern::PresievePattern (const std::vector<std::uint64_t>& moduli, std::uint64_t first, std::uint64_t step)
+    : pattern (Period (moduli) * 64, true)
+{
+    // 64 periods fill a whole number of words, so the pattern can be stamped a word at a time.
+    for (std::uint64_t modulus : moduli)
+    {
+        // Find the first bit representing a multiple of 'modulus'; the bits representing multiples recur every
+        // 'modulus' bits thereafter, as 'step' is coprime to 'modulus'.
+        std::uint64_t firstMultiple = 0;
+
+        while ((first + firstMultiple * step) % modulus != 0)
+            ++firstMultiple;
+
+        pattern.ResetStride (firstMultiple, pattern.Count (), modulus);
+    }
+}
+
+void PresievePattern::Apply (BitArray& sieve, std::size_t begin, std::size_t end, std::size_t patternBegin) const
+{
+    sieve.Stamp (begin, end, pattern, patternBegin);
+}
+
+std::uint64_t PresievePattern::Period (const std::vector<std::uint64_t>& moduli)
+{
+    std::uint64_t period = 1;
+
+    for (std::uint64_t modulus : moduli)
+        period *= modulus;
+
+    return period;
+}
+
+const std::vector<std::uint64_t>& OddPresievePrimes ()
+{
+    // The product of these primes is 15015, so the pattern occupies 15015 words and fits in L2 cache.
+    static const std::vector<std::uint64_t> primes { 3, 5, 7, 11, 13 };
+    return primes;
+}
+
+const PresievePattern& OddPresievePattern ()
+{
+    static const PresievePattern pattern (OddPresievePrimes (), 1, 2);
+    return pattern;
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "BitArray.h"
+
+// The periodic bit pattern left over an arithmetic progression after striking out the multiples of a few small moduli.
+// Stamping the pattern over a sieve replaces the individual strike-outs for those moduli,
+// which would otherwise dominate the sieving time.
+class PresievePattern
+{
+private:
+    // One period of the pattern, repeated until it spans a whole number of 64-bit words.
+    BitArray pattern;
+
+public:
+    // Constructs the pattern in which bit 'i' represents 'first' + 'i' * 'step',
+    // and is false exactly when that number is divisible by one of 'moduli'.
+    // 'step' must be coprime to every element of 'moduli'.
+    PresievePattern (const std::vector<std::uint64_t>& moduli, std::uint64_t first, std::uint64_t step);
+
+    // Overwrites the bits in ['begin', 'end') of 'sieve' with the pattern,
+    // where bit 'begin' of 'sieve' represents the same number as bit 'patternBegin' of the pattern.
+    // 'begin' and 'patternBegin' must be multiples of 64,
+    // and 'end' must be a multiple of 64 or equal to 'sieve.Count ()'.
+    void Apply (BitArray& sieve, std::size_t begin, std::size_t end, std::size_t patternBegin) const;
+
+    // Returns the product of the moduli, which is the period of the pattern.
+    static std::uint64_t Period (const std::vector<std::uint64_t>& moduli);
+};
+
+// Returns the odd primes whose multiples are struck out by 'OddPresievePattern ()'.
+const std::vector<std::uint64_t>& OddPresievePrimes ();
+
+// Returns the pattern in which bit 'i' represents the odd number 2 * 'i' + 1,
+// and is false exactly when that number is divisible by one of 'OddPresievePrimes ()'.
+// This is the layout of the odd-only prime sieves.
+const PresievePattern& OddPresievePattern ();
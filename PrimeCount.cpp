@@ -1,7 +1,14 @@
 #include "PrimeCount.h"
 
+#include <atomic>
 #include <cmath>
+#include <cstddef>
 #include <cstdint>
+#include <thread>
+#include <vector>
+
+#include "Exponent.h"
+#include "PrimeSieve.h"
 
 std::uint64_t LegendreCount (std::uint64_t n)
 {
@@ -13,3 +20,158 @@ std::uint64_t LiCount (std::uint64_t n)
     // Wikipedia assures me that this is correct.
     return std::expint (std::log (n));
 }
+
+/*
+* Meissel-Lehmer: with 'a' the number of primes up to the cube root of 'n',
+* pi ('n') = phi ('n', 'a') + 'a' - 1 - P2 ('n', 'a'),
+* where phi ('x', 'a') counts the integers in [1, 'x'] with no prime factor among the first 'a' primes,
+* and P2 ('n', 'a') counts those integers up to 'n' that are products of exactly two such primes.
+* Every prime count needed is of a number below 'n' divided by the cube root of 'n', which a sieve answers directly.
+*/
+
+// The number of leading primes for which phi is read from a periodic table rather than expanded.
+static constexpr std::size_t tabulatedPrimeCount = 6;
+
+// The state shared by every evaluation of phi within one call to 'PrimePiExact'.
+struct PhiContext
+{
+    // The sieve answering prime counts below its limit.
+    const PrimeSieve<std::uint64_t>& sieve;
+
+    // The primes up to the square root of 'n', and the prime succeeding them.
+    std::vector<std::uint64_t> primes;
+
+    // The product of the first 'a' primes at index 'a'.
+    std::vector<std::uint64_t> products;
+
+    // At index 'a', a table of phi ('r', 'a') for 'r' in [0, 'products[a]'].
+    std::vector<std::vector<std::uint32_t>> tables;
+};
+
+// Returns phi ('x', 'a') for 'a' not exceeding 'tabulatedPrimeCount', using the periodicity of phi in 'x'.
+static std::uint64_t TabulatedPhi (std::uint64_t x, std::size_t a, const PhiContext& context)
+{
+    std::uint64_t period = context.products[a];
+    return x / period * context.tables[a][period] + context.tables[a][x % period];
+}
+
+// Returns phi ('x', 'a').
+static std::uint64_t Phi (std::uint64_t x, std::size_t a, const PhiContext& context)
+{
+    if (a <= tabulatedPrimeCount)
+        return TabulatedPhi (x, a, context);
+
+    const std::vector<std::uint64_t>& primes = context.primes;
+
+    // If 'x' is less than the square of the ('a' + 1)-th prime, the only survivors are 1 and the primes after the 'a'-th.
+    if (x < context.sieve.Limit () && x < primes[a] * primes[a])
+        return x >= primes[a - 1] ? context.sieve.PrimePi (x) - a + 1 : std::uint64_t (x > 0);
+
+    // Expand phi ('x', 'a') = phi ('x', 'a' - 1) - phi ('x' / p_'a', 'a' - 1) down to the tabulated primes.
+    std::uint64_t result = TabulatedPhi (x, tabulatedPrimeCount, context);
+
+    for (std::size_t i = tabulatedPrimeCount + 1; i <= a; ++i)
+    {
+        std::uint64_t quotient = x / primes[i - 1];
+
+        if (quotient < primes[i - 1])
+        {
+            // Every remaining term is phi of a positive quotient below the prime divided by, which is just 1,
+            // or phi of 0 once the prime exceeds 'x'.
+            std::size_t last = x >= primes[a - 1] ? a : context.sieve.PrimePi (x);
+
+            if (last >= i)
+                result -= last - i + 1;
+
+            break;
+        }
+
+        result -= Phi (quotient, i - 1, context);
+    }
+
+    return result;
+}
+
+std::uint64_t PrimePiExact (std::uint64_t n, std::size_t threadCount)
+{
+    // Small arguments are answered by sieving directly.
+    if (n < (1 << 20))
+        return PrimeSieve<std::uint64_t> (n + 1).Count ();
+
+    std::uint64_t cubeRoot = IntegerRoot (n, 3);
+    std::uint64_t squareRoot = IntegerSqrt (n);
+    // Every prime count needed is of a number not exceeding 'n' / 'cubeRoot'.
+    PrimeSieve<std::uint64_t> sieve (n / cubeRoot + 1, false, threadCount);
+    PhiContext context { sieve, {}, {}, {} };
+
+    for (std::uint64_t prime : sieve)
+    {
+        context.primes.emplace_back (prime);
+
+        if (prime > squareRoot)
+            break;
+    }
+
+    context.products.emplace_back (1);
+
+    for (std::size_t a = 0; a <= tabulatedPrimeCount; ++a)
+    {
+        if (a > 0)
+            context.products.emplace_back (context.products.back () * context.primes[a - 1]);
+
+        std::vector<std::uint32_t> table (context.products[a] + 1, 0);
+
+        for (std::uint64_t r = 1; r <= context.products[a]; ++r)
+        {
+            bool isCoprime = true;
+
+            for (std::size_t i = 0; i < a; ++i)
+                isCoprime = isCoprime && r % context.primes[i] != 0;
+
+            table[r] = table[r - 1] + isCoprime;
+        }
+
+        context.tables.emplace_back (std::move (table));
+    }
+
+    std::size_t a = sieve.PrimePi (cubeRoot);
+
+    // phi ('n', 'a') = phi ('n', 'tabulatedPrimeCount') - the sum over 'i' in ('tabulatedPrimeCount', 'a']
+    // of phi ('n' / p_'i', 'i' - 1).
+    // The terms are independent, so threads claim them one at a time, heaviest first.
+    std::atomic<std::size_t> nextTerm = tabulatedPrimeCount + 1;
+    std::vector<std::uint64_t> threadSums (std::max (std::size_t (1), threadCount), 0);
+
+    auto sumTerms = [&] (std::size_t thread)
+    {
+        std::uint64_t sum = 0;
+
+        for (std::size_t i = nextTerm++; i <= a; i = nextTerm++)
+            sum += Phi (n / context.primes[i - 1], i - 1, context);
+
+        threadSums[thread] = sum;
+    };
+
+    std::vector<std::thread> threads;
+
+    for (std::size_t thread = 1; thread < threadSums.size (); ++thread)
+        threads.emplace_back (sumTerms, thread);
+
+    sumTerms (0);
+
+    for (std::thread& thread : threads)
+        thread.join ();
+
+    std::uint64_t phi = TabulatedPhi (n, tabulatedPrimeCount, context);
+
+    for (std::uint64_t threadSum : threadSums)
+        phi -= threadSum;
+
+    // P2 ('n', 'a') = the sum over primes p_'b' in ('cubeRoot', 'squareRoot'] of pi ('n' / p_'b') - 'b' + 1.
+    std::uint64_t p2 = 0;
+
+    for (std::size_t b = a + 1; b <= context.primes.size () && context.primes[b - 1] <= squareRoot; ++b)
+        p2 += sieve.PrimePi (n / context.primes[b - 1]) - b + 1;
+
+    return phi + a - 1 - p2;
+}
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstddef>
 #include <cstdint>
 
 // Returns Legendre's approximation for the number of primes in [0, 'n'].
@@ -7,3 +8,7 @@ std::uint64_t LegendreCount (std::uint64_t n);
 
 // Returns the logarithmic integral approximation for the number of primes in [0, 'n'].
 std::uint64_t LiCount (std::uint64_t n);
+
+// Returns the exact number of primes in [0, 'n'] by the Meissel-Lehmer method, using up to 'threadCount' threads.
+// Only a sieve up to about 'n' to the power 2/3 is built, so 'n' may range far beyond what a PrimeSieve can hold.
+std::uint64_t PrimePiExact (std::uint64_t n, std::size_t threadCount = 1);
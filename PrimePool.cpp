@@ -0,0 +1,93 @@
+#include "PrimePool.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "PrimeSieve.h"
+
+PrimePool::PrimePool (std::shared_ptr<const primes_t> primes)
+    : primes (primes) {}
+
+PrimePool::PrimePool (std::shared_ptr<const PrimeSieve<std::uint64_t>> sieve)
+    : sieve (sieve) {}
+
+bool PrimePool::First (Cursor& cursor) const
+{
+    if (primes)
+    {
+        if (primes->empty ())
+            return false;
+
+        cursor = { 0, primes->front () };
+        return true;
+    }
+
+    std::uint64_t prime = sieve->NextPrime (0);
+
+    if (prime == sieve->Limit ())
+        return false;
+
+    cursor = { 0, prime };
+    return true;
+}
+
+bool PrimePool::Next (Cursor& cursor) const
+{
+    if (primes)
+    {
+        if (cursor.index + 1 >= primes->size ())
+            return false;
+
+        ++cursor.index;
+        cursor.prime = (*primes)[cursor.index];
+        return true;
+    }
+
+    // Scan the sieve for the prime succeeding 'cursor.prime'.
+    std::uint64_t prime = sieve->NextPrime (cursor.prime + 1);
+
+    if (prime == sieve->Limit ())
+        return false;
+
+    ++cursor.index;
+    cursor.prime = prime;
+    return true;
+}
+
+bool PrimePool::Seek (std::uint64_t n, Cursor& cursor) const
+{
+    if (primes)
+    {
+        auto prime = std::lower_bound (primes->cbegin (), primes->cend (), n);
+
+        if (prime == primes->cend ())
+            return false;
+
+        cursor = { std::size_t (prime - primes->cbegin ()), *prime };
+        return true;
+    }
+
+    if (n >= sieve->Limit ())
+        return false;
+
+    std::uint64_t prime = sieve->NextPrime (n);
+
+    if (prime == sieve->Limit ())
+        return false;
+
+    cursor = { 0, prime };
+    return true;
+}
+
+std::size_t PrimePool::CountTo (const Cursor& cursor, std::uint64_t n) const
+{
+    if (n < cursor.prime)
+        return 0;
+
+    if (primes)
+        return std::upper_bound (primes->cbegin () + cursor.index, primes->cend (), n) - primes->cbegin () - cursor.index;
+
+    return sieve->PrimePi (std::min (n, sieve->Limit () - 1)) - sieve->PrimePi (cursor.prime - 1);
+}
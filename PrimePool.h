@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "PrimeSieve.h"
+
+using primes_t = std::vector<std::uint64_t>;
+
+// A pool of primes in increasing order, backed either by an explicit list of primes
+// or by a sieve whose primes are found on demand without materializing a list.
+class PrimePool
+{
+private:
+    // The explicit list of primes, if the pool is backed by a list.
+    std::shared_ptr<const primes_t> primes;
+
+    // The sieve, if the pool is backed by a sieve.
+    std::shared_ptr<const PrimeSieve<std::uint64_t>> sieve;
+
+public:
+    // A position in a PrimePool.
+    struct Cursor
+    {
+        // The index of 'prime' in the list, if the pool is backed by a list.
+        std::size_t index;
+
+        // The prime at this position.
+        std::uint64_t prime;
+    };
+
+    // Constructs a PrimePool backed by an explicit list of primes in increasing order.
+    PrimePool (std::shared_ptr<const primes_t> primes);
+
+    // Constructs a PrimePool backed by the primes in a sieve.
+    PrimePool (std::shared_ptr<const PrimeSieve<std::uint64_t>> sieve);
+
+    // Points 'cursor' at the least prime in the pool and returns true, or returns false if the pool is empty.
+    bool First (Cursor& cursor) const;
+
+    // Moves 'cursor' forward to the next prime in the pool and returns true,
+    // or leaves 'cursor' unchanged and returns false if it points at the last prime in the pool.
+    bool Next (Cursor& cursor) const;
+
+    // Points 'cursor' at the least prime in the pool not less than 'n' and returns true,
+    // or leaves 'cursor' unchanged and returns false if there is no such prime.
+    bool Seek (std::uint64_t n, Cursor& cursor) const;
+
+    // Returns the number of primes in the pool in ['cursor.prime', 'n'], without visiting them.
+    // A sieve-backed pool answers from the rank index of the sieve, built on the first call.
+    std::size_t CountTo (const Cursor& cursor, std::uint64_t n) const;
+};
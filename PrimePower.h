@@ -1,9 +1,11 @@
 #pragma once
 
 #include <concepts>
+#include <cstddef>
 #include <cstdint>
 
 #include "Exponent.h"
+#include "FixedVector.h"
 
 // A prime power.
 template<std::unsigned_integral TPrime, std::unsigned_integral TPower>
@@ -15,6 +17,9 @@ struct PrimePower
     // The power.
     TPower power;
 
+    // Constructs a PrimePower with unspecified values, to be assigned later.
+    PrimePower () = default;
+
     // Constructs a PrimePower.
     PrimePower (TPrime prime, TPower power)
         : prime (prime), power (power) {}
@@ -25,3 +30,10 @@ struct PrimePower
         return IntegerPow (std::uint64_t (prime), power);
     }
 };
+
+// The greatest number of distinct primes dividing a 64-bit integer; the product of the first 16 primes exceeds 2^64.
+constexpr std::size_t maximumPrimeFactorCount = 15;
+
+// An inline buffer large enough to hold the prime factorization of any 64-bit integer.
+template<std::unsigned_integral T>
+using PrimeFactorsBuffer = FixedVector<PrimePower<T, std::uint32_t>, maximumPrimeFactorCount>;
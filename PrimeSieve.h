@@ -6,99 +6,334 @@
 #include <iostream>
 #include <iterator>
 #include <memory>
+#include <mutex>
+#include <thread>
 #include <vector>
 
 #include "BitArray.h"
+#include "Exponent.h"
+#include "Presieve.h"
 
 // An Eratosthenes prime sieve.
 template<std::unsigned_integral T>
 class PrimeSieve
 {
 private:
-    // The underlying bit array.
+    // The number of bits of 'sieve' struck out at a time, chosen so that each window stays resident in cache.
+    static constexpr T windowSize = T (1) << 18;
+
+    // The number of bits of 'sieve' covered by each entry of 'blockRanks', one cache line's worth.
+    static constexpr std::size_t blockSize = 512;
+
+    // The underlying bit array, in which bit 'i' represents the odd number 2 * 'i' + 1.
+    // Even numbers are not stored, halving the memory and the work spent striking them out.
     BitArray sieve;
 
     // The exclusive upper bound on the numbers sieved.
     T limit;
 
-    // The primes in [0, 'limit').
-    std::shared_ptr<std::vector<T>> primes;
+    // The number of primes in [0, 'limit').
+    std::size_t count;
+
+    // The primes in [0, 'limit'), materialized on the first call to 'Primes ()'.
+    mutable std::shared_ptr<std::vector<T>> primes;
+
+    // Guards the materialization of 'primes'.
+    mutable std::once_flag primesFlag;
+
+    // The number of true bits of 'sieve' before bit 'i' * 'blockSize' at index 'i',
+    // built on the first call to 'PrimePi ()'.
+    mutable std::vector<std::size_t> blockRanks;
+
+    // Guards the construction of 'blockRanks'.
+    mutable std::once_flag blockRanksFlag;
 
 public:
-    // Constructs a PrimeSieve over [0, 'limit') and optionally outputs progress to 'clog'.
-    PrimeSieve (T limit, bool verbose = false)
-        : limit (limit),
-        sieve (limit, true),
-        primes (std::make_shared<std::vector<T>> ())
+    // A forward iterator over the primes in a PrimeSieve, each found by scanning the bit array on demand.
+    class Iterator
     {
-        // Standard Eratosthenes sieve algorithm.
-        sieve.Reset (0);
-        sieve.Reset (1);
-        T prime = 2;
-        primes->emplace_back (2);
+    private:
+        // The sieve being iterated over.
+        const PrimeSieve* primeSieve;
+
+        // The current prime, or the limit of 'primeSieve' in the end state.
+        T prime;
+
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = T;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const T*;
+        using reference = T;
+
+        // Constructs a singular Iterator.
+        Iterator ()
+            : primeSieve (nullptr), prime (0) {}
+
+        // Constructs an Iterator over 'primeSieve' pointing at 'prime'.
+        Iterator (const PrimeSieve* primeSieve, T prime)
+            : primeSieve (primeSieve), prime (prime) {}
+
+        // Returns the current prime.
+        T operator* () const
+        {
+            return prime;
+        }
+
+        // Moves the iterator forward to the next prime.
+        Iterator& operator++ ()
+        {
+            prime = primeSieve->NextPrime (prime + 1);
+            return *this;
+        }
+
+        // Moves the iterator forward to the next prime and returns its previous state.
+        Iterator operator++ (int)
+        {
+            Iterator previous = *this;
+            ++(*this);
+            return previous;
+        }
+
+        // Returns whether two iterators point at the same prime.
+        bool operator== (const Iterator& other) const
+        {
+            return prime == other.prime;
+        }
+    };
+
+    // Constructs a PrimeSieve over [0, 'limit') using up to 'threadCount' threads
+    // and optionally outputs progress to 'clog'.
+    PrimeSieve (T limit, bool verbose = false, std::size_t threadCount = 1)
+        : sieve (limit / 2, true),
+        limit (limit),
+        count (0)
+    {
+        if (limit <= 2)
+        {
+            if (limit == 2)
+                sieve.Reset (0);
+
+            return;
+        }
+
+        T baseLimit = IntegerSqrt (limit - 1) + 1;
+        T sieveSize = limit / 2;
+        T firstWindow = baseLimit / 2 / windowSize;
+        T windowCount = (sieveSize + windowSize - 1) / windowSize - firstWindow;
 
+        // Stamp the presieve pattern over every window up to and including the one containing 'baseLimit',
+        // then restore the presieved primes themselves.
         if (verbose)
-            while (prime * prime < limit)
+            std::clog << "Presieving multiples of 3, 5, 7, 11 and 13\n";
+
+        OddPresievePattern ().Apply (sieve, 0, std::min (sieveSize, (firstWindow + 1) * windowSize), 0);
+
+        for (std::uint64_t prime : OddPresievePrimes ())
+            if (prime < limit)
+                sieve.Set (prime / 2);
+
+        // 1 is not prime, and 2 is the only even prime.
+        sieve.Reset (0);
+        count = 1;
+
+        // The odd primes in [0, 'baseLimit'), and those among them whose multiples are struck out individually.
+        std::vector<T> basePrimes;
+        std::vector<T> sievingPrimes;
+
+        // Standard Eratosthenes sieve algorithm over the odd numbers in [0, 'baseLimit'), which contain every odd prime
+        // whose multiples need to be struck out of the remainder of the sieve.
+        // Only odd multiples of each odd prime are struck out, so successive multiples are 2 * 'prime' apart,
+        // or 'prime' apart in 'sieve'.
+        for (T prime = 3; prime < baseLimit; prime += 2)
+            if (sieve.Get (prime / 2))
             {
-                std::clog << "Striking out multiples of " << prime << "\n";
-
-                for (T i = prime * prime; i < limit; i += prime)
-                    sieve.Reset (i);
-
-                for (T i = prime + 1; ; ++i)
-                    if (sieve.Get (i))
-                    {
-                        prime = i;
-                        primes->emplace_back (i);
-                        break;
-                    }
+                basePrimes.emplace_back (prime);
+
+                if (prime <= OddPresievePrimes ().back ())
+                    continue;
+
+                if (verbose)
+                    std::clog << "Striking out multiples of " << prime << "\n";
+
+                sieve.ResetStride (prime * prime / 2, baseLimit / 2, prime);
+                sievingPrimes.emplace_back (prime);
             }
-        else
-            while (prime * prime < limit)
+
+        count += basePrimes.size ();
+
+        // Cache-blocked Eratosthenes sieve algorithm over the odd numbers in ['baseLimit', 'limit'),
+        // working on indices into 'sieve'.
+        // Windows are aligned to multiples of 'windowSize' so that no two windows share a word of 'sieve',
+        // and each thread is handed a contiguous run of windows.
+        threadCount = std::max (std::size_t (1), std::min (threadCount, std::size_t (windowCount)));
+
+        // The number of primes found by each thread.
+        std::vector<std::size_t> threadCounts (threadCount, 0);
+        std::mutex clogMutex;
+
+        auto sieveWindows = [&] (std::size_t thread)
+        {
+            T start = std::max (baseLimit / 2, (firstWindow + T (windowCount * thread / threadCount)) * windowSize);
+            T end = std::min (sieveSize, (firstWindow + T (windowCount * (thread + 1) / threadCount)) * windowSize);
+
+            // The index in 'sieve' of the next odd multiple of each sieving prime to strike out,
+            // carried over from one window to the next.
+            std::vector<T> nextMultiples;
+
+            for (T prime : sievingPrimes)
             {
-                for (T i = prime * prime; i < limit; i += prime)
-                    sieve.Reset (i);
-
-                for (T i = prime + 1; ; ++i)
-                    if (sieve.Get (i))
-                    {
-                        prime = i;
-                        primes->emplace_back (i);
-                        break;
-                    }
+                T multiple = std::max (prime * prime, (2 * start + prime) / prime * prime);
+
+                if (multiple % 2 == 0)
+                    multiple += prime;
+
+                nextMultiples.emplace_back (multiple / 2);
             }
 
-        for (T i = prime + 1; i < limit; ++i)
-            if (sieve.Get (i))
-                primes->emplace_back (i);
+            // Each window is presieved and struck out by every sieving prime,
+            // then its primes are counted while still in cache.
+            std::size_t windowsCount = 0;
+
+            for (T windowStart = start; windowStart < end; )
+            {
+                T windowEnd = std::min (end, (windowStart / windowSize + 1) * windowSize);
+
+                if (verbose)
+                {
+                    std::lock_guard<std::mutex> lock (clogMutex);
+                    std::clog
+                        << "Sieving [" << 2 * windowStart + 1 << ", " << std::min (2 * windowEnd, limit) << ")\n";
+                }
+
+                // Windows not aligned to 'windowSize' were presieved along with the base primes.
+                if (windowStart % windowSize == 0)
+                    OddPresievePattern ().Apply (sieve, windowStart, windowEnd, windowStart);
+
+                for (std::size_t i = 0; i < sievingPrimes.size (); ++i)
+                    nextMultiples[i] = sieve.ResetStride (nextMultiples[i], windowEnd, sievingPrimes[i]);
+
+                windowsCount += sieve.CountSet (windowStart, windowEnd);
+
+                windowStart = windowEnd;
+            }
+
+            threadCounts[thread] = windowsCount;
+        };
+
+        std::vector<std::thread> threads;
+
+        for (std::size_t thread = 1; thread < threadCount; ++thread)
+            threads.emplace_back (sieveWindows, thread);
+
+        sieveWindows (0);
+
+        for (std::thread& thread : threads)
+            thread.join ();
+
+        for (std::size_t threadPrimeCount : threadCounts)
+            count += threadPrimeCount;
     }
 
+    // PrimeSieve hands out pointers to itself through its iterators, so it is neither copied nor moved.
+    PrimeSieve (const PrimeSieve&) = delete;
+    PrimeSieve& operator= (const PrimeSieve&) = delete;
+
     // Returns the primes in [0, 'limit').
+    // The list is materialized on the first call and occupies memory proportional to the number of primes;
+    // prefer iterating over the sieve itself where random access is not needed.
     std::shared_ptr<const std::vector<T>> Primes () const
     {
+        std::call_once
+        (
+            primesFlag,
+            [this] ()
+            {
+                primes = std::make_shared<std::vector<T>> ();
+                primes->reserve (count);
+
+                for (T prime : *this)
+                    primes->emplace_back (prime);
+            }
+        );
+
         return primes;
     }
 
+    // Returns an iterator pointing at the least prime in [0, 'limit').
+    Iterator begin () const
+    {
+        return Iterator (this, NextPrime (0));
+    }
+
+    // Returns an iterator in the end state.
+    Iterator end () const
+    {
+        return Iterator (this, limit);
+    }
+
+    // Returns the least prime not less than 'n', or 'limit' if there is no such prime in [0, 'limit').
+    T NextPrime (T n) const
+    {
+        if (n <= 2)
+            return limit > 2 ? 2 : limit;
+
+        // Scan the odd numbers from 'n' onwards a word at a time.
+        T next = sieve.FindNextSet (n / 2);
+        return next < limit / 2 ? 2 * next + 1 : limit;
+    }
+
+    // Returns the exclusive upper bound on the numbers sieved.
+    T Limit () const
+    {
+        return limit;
+    }
+
     // Returns the number of primes in [0, 'limit').
     std::size_t Count () const
     {
-        return primes->size ();
+        return count;
     }
 
     // Returns the number of primes in [0, 'n'], if 'n' is in [0, 'limit').
     // Out of range arguments result in undefined behaviour.
+    // The first call builds a rank index over the sieve, after which each call costs a lookup and one block popcount.
     std::size_t PrimePi (T n) const
     {
-        // Find the first prime which exceeds 'n'.
-        auto nextPrime = std::upper_bound (primes->cbegin (), primes->cend (), n);
-        // Return the index of the prime just discovered.
-        return std::distance (primes->cbegin (), nextPrime);
+        std::call_once
+        (
+            blockRanksFlag,
+            [this] ()
+            {
+                std::size_t rank = 0;
+                blockRanks.reserve (sieve.Count () / blockSize + 1);
+
+                for (std::size_t block = 0; block < sieve.Count (); block += blockSize)
+                {
+                    blockRanks.emplace_back (rank);
+                    rank += sieve.CountSet (block, std::min (block + blockSize, sieve.Count ()));
+                }
+
+                blockRanks.emplace_back (rank);
+            }
+        );
+
+        if (n < 2)
+            return 0;
+
+        // The odd numbers in [0, 'n'] occupy bits [0, ('n' + 1) / 2) of 'sieve'; add 1 for the prime 2.
+        std::size_t bits = (n + 1) / 2;
+        std::size_t block = bits / blockSize;
+        return 1 + blockRanks[block] + sieve.CountSet (block * blockSize, bits);
     }
 
     // Returns whether 'n' is prime, if 'n' is in [0, 'limit').
     // Out of range arguments result in undefined behaviour.
     bool IsPrime (T n) const
     {
-        return sieve.Get (n);
+        if (n % 2 == 0)
+            return n == 2;
+
+        return sieve.Get (n / 2);
     }
 };
@@ -0,0 +1,152 @@
+#include "PrimeSieveCache.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "PrimeSieve.h"
+
+// Returns the number of bytes held by a sieve over [0, 'limit'): its bit array, which stores one bit per odd number,
+// and the rank index built by 'PrimePi', which stores 8 bytes per 512 bits.
+static std::size_t SieveBytes (std::uint64_t limit)
+{
+    return limit / 16 + limit / 128;
+}
+
+PrimeSieveCache::PrimeSieveCache (std::size_t maximumEntries, std::size_t maximumBytes)
+    : maximumEntries (maximumEntries),
+    maximumBytes (maximumBytes),
+    clock (0) {}
+
+std::shared_ptr<const PrimeSieve<std::uint64_t>> PrimeSieveCache::Find (std::uint64_t limit)
+{
+    Entry* best = nullptr;
+
+    for (Entry& entry : entries)
+        if (entry.sieve->Limit () >= limit && (best == nullptr || entry.sieve->Limit () < best->sieve->Limit ()))
+            best = &entry;
+
+    if (best == nullptr)
+        return nullptr;
+
+    best->lastUse = ++clock;
+    return best->sieve;
+}
+
+void PrimeSieveCache::Evict (const PrimeSieve<std::uint64_t>* keep)
+{
+    std::size_t bytes = 0;
+
+    for (const Entry& entry : entries)
+        bytes += SieveBytes (entry.sieve->Limit ());
+
+    while (entries.size () > maximumEntries || bytes > maximumBytes)
+    {
+        auto victim = entries.end ();
+
+        for (auto entry = entries.begin (); entry != entries.end (); ++entry)
+            if (entry->sieve.get () != keep && (victim == entries.end () || entry->lastUse < victim->lastUse))
+                victim = entry;
+
+        if (victim == entries.end ())
+            return;
+
+        bytes -= SieveBytes (victim->sieve->Limit ());
+        entries.erase (victim);
+    }
+}
+
+std::shared_ptr<const PrimeSieve<std::uint64_t>> PrimeSieveCache::Get (std::uint64_t limit, std::size_t threadCount)
+{
+    std::unique_lock<std::mutex> lock (entriesMutex);
+
+    if (auto sieve = Find (limit))
+        return sieve;
+
+    // Wait for the smallest sieve being built that is large enough, if it is no more than twice as large as needed;
+    // a miss far below every such build builds its own rather than waiting for a much larger one.
+    const Build* pending = nullptr;
+    std::uint64_t largestLimit = 0;
+
+    for (const Build& build : builds)
+        if (build.limit >= limit)
+        {
+            if (pending == nullptr || build.limit < pending->limit)
+                pending = &build;
+        }
+        else
+            largestLimit = std::max (largestLimit, build.limit);
+
+    if (pending != nullptr && pending->limit / 2 <= limit)
+    {
+        std::shared_future<std::shared_ptr<const PrimeSieve<std::uint64_t>>> sieve = pending->sieve;
+        lock.unlock ();
+        return sieve.get ();
+    }
+
+    // Every cached sieve is below 'limit', as 'Find' failed.
+    for (const Entry& entry : entries)
+        largestLimit = std::max (largestLimit, entry.sieve->Limit ());
+
+    // Grow geometrically, unless doubling would by itself exceed the memory limit.
+    // The new limit is below twice 'limit', so it differs from that of every other build: those at least 'limit'
+    // are more than twice 'limit'.
+    std::uint64_t newLimit = limit;
+
+    if (largestLimit > limit / 2 && largestLimit <= std::uint64_t (-1) / 2 && SieveBytes (2 * largestLimit) <= maximumBytes)
+        newLimit = 2 * largestLimit;
+
+    std::promise<std::shared_ptr<const PrimeSieve<std::uint64_t>>> promise;
+    builds.push_back ({ newLimit, promise.get_future ().share () });
+    lock.unlock ();
+
+    std::shared_ptr<const PrimeSieve<std::uint64_t>> sieve;
+
+    try
+    {
+        sieve = std::make_shared<const PrimeSieve<std::uint64_t>> (newLimit, false, threadCount);
+    }
+    catch (...)
+    {
+        lock.lock ();
+        std::erase_if (builds, [newLimit] (const Build& build) { return build.limit == newLimit; });
+        promise.set_exception (std::current_exception ());
+        throw;
+    }
+
+    lock.lock ();
+    std::erase_if (builds, [newLimit] (const Build& build) { return build.limit == newLimit; });
+
+    // A sieve exceeding the memory limit on its own is handed out without being cached.
+    if (SieveBytes (newLimit) <= maximumBytes)
+    {
+        entries.push_back ({ sieve, ++clock });
+        Evict (sieve.get ());
+    }
+
+    promise.set_value (sieve);
+    return sieve;
+}
+
+std::size_t PrimeSieveCache::Size () const
+{
+    std::lock_guard<std::mutex> lock (entriesMutex);
+    return entries.size ();
+}
+
+void PrimeSieveCache::Clear ()
+{
+    std::lock_guard<std::mutex> lock (entriesMutex);
+    entries.clear ();
+}
+
+PrimeSieveCache& DefaultPrimeSieveCache ()
+{
+    static PrimeSieveCache cache;
+    return cache;
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "PrimeSieve.h"
+
+// A thread-safe cache of PrimeSieve objects, handing out shared read-only handles so that callers needing primes
+// up to similar limits share one sieve instead of each building their own.
+// A request beyond every cached sieve builds a new one with at least double the limit of the largest,
+// so a sequence of growing requests sieves only logarithmically many times.
+// Sieves are evicted least recently used first once there are too many or they occupy too much memory;
+// handles already given out keep an evicted sieve alive, and a sieve exceeding the memory limit on its own
+// is handed out without being cached.
+class PrimeSieveCache
+{
+private:
+    // A cached sieve.
+    struct Entry
+    {
+        // The sieve.
+        std::shared_ptr<const PrimeSieve<std::uint64_t>> sieve;
+
+        // The value of 'clock' when the sieve was last handed out.
+        std::uint64_t lastUse;
+    };
+
+    // A sieve being built.
+    struct Build
+    {
+        // The limit of the sieve.
+        std::uint64_t limit;
+
+        // Becomes ready with the sieve once it has been built.
+        std::shared_future<std::shared_ptr<const PrimeSieve<std::uint64_t>>> sieve;
+    };
+
+    // The cached sieves, in no particular order.
+    std::vector<Entry> entries;
+
+    // The sieves being built, in no particular order.
+    std::vector<Build> builds;
+
+    // The maximum number of sieves held.
+    std::size_t maximumEntries;
+
+    // The maximum number of bytes of bit arrays and rank indices held across every sieve.
+    std::size_t maximumBytes;
+
+    // Counts requests, ordering the entries by recency of use.
+    std::uint64_t clock;
+
+    // Guards 'entries', 'builds' and 'clock'; never held while building a sieve.
+    mutable std::mutex entriesMutex;
+
+    // Returns the cached sieve with the least limit not less than 'limit', marking it used, or null if there is none.
+    // 'entriesMutex' must be held.
+    std::shared_ptr<const PrimeSieve<std::uint64_t>> Find (std::uint64_t limit);
+
+    // Evicts least recently used sieves other than 'keep' until the limits on count and memory are met.
+    // 'entriesMutex' must be held.
+    void Evict (const PrimeSieve<std::uint64_t>* keep);
+
+public:
+    // Constructs an empty PrimeSieveCache holding at most 'maximumEntries' sieves and 'maximumBytes' bytes of sieve.
+    PrimeSieveCache (std::size_t maximumEntries = 4, std::size_t maximumBytes = std::size_t (1) << 30);
+
+    // Returns a sieve over [0, 'limit'') for some 'limit'' not less than 'limit',
+    // building it using up to 'threadCount' threads if no cached sieve is large enough.
+    // A miss waits for a sieve already being built if that is large enough but no more than twice 'limit',
+    // and otherwise builds its own alongside, so that small requests are never held up behind a large build.
+    // The sieve may contain primes beyond 'limit', which callers needing exactly the primes below 'limit' must skip.
+    std::shared_ptr<const PrimeSieve<std::uint64_t>> Get (std::uint64_t limit, std::size_t threadCount = 1);
+
+    // Returns the number of sieves held.
+    std::size_t Size () const;
+
+    // Evicts every sieve.
+    void Clear ();
+};
+
+// Returns the process-wide PrimeSieveCache used by default wherever a sieve up to a bound is needed.
+PrimeSieveCache& DefaultPrimeSieveCache ();
@@ -1,8 +1,27 @@
 #include "PrimeTest.h"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <thread>
+#include <vector>
+
 #include <gmp.h>
 #include <gmpxx.h>
 
-bool FermatProbabilisticTest (const mpz_class n, const mpz_class base)
+#include "BitArray.h"
+#include "Montgomery.h"
+
+// Jim Sinclair's bases; together they detect every composite below 2^64.
+static constexpr std::uint64_t deterministicBases[] = { 2, 325, 9375, 28178, 450775, 9780504, 1795265022 };
+
+// The number of candidates exponentiated in lockstep by the batch test.
+static constexpr std::size_t laneCount = 4;
+
+bool FermatProbabilisticTest (const mpz_class& n, const mpz_class& base)
 {
     // Standard Fermat test algorithm.
     mpz_class exponent = n - 1;
@@ -11,7 +30,7 @@ bool FermatProbabilisticTest (const mpz_class n, const mpz_class base)
     return power == 1;
 }
 
-bool MillerRabinProbabilisticTest (const mpz_class n, const mpz_class base)
+bool MillerRabinProbabilisticTest (const mpz_class& n, const mpz_class& base)
 {
     // Standard Miller-Rabin test algorithm.
     mpz_class oddPartExponent = n - 1;
@@ -41,3 +60,321 @@ bool MillerRabinProbabilisticTest (const mpz_class n, const mpz_class base)
 
     return false;
 }
+
+// Decides whether 'n' is prime if it is below 2, has a prime factor up to 13, or is below 17^2,
+// in which case 'prime' receives the answer and true is returned.
+// Cheap divisibility checks settle most composites this way and leave only odd 'n' for the Montgomery arithmetic.
+static bool SettleBySmallPrimes (std::uint64_t n, bool& prime)
+{
+    static constexpr std::uint64_t smallPrimes[] = { 2, 3, 5, 7, 11, 13 };
+
+    if (n < 2)
+    {
+        prime = false;
+        return true;
+    }
+
+    for (std::uint64_t smallPrime : smallPrimes)
+        if (n % smallPrime == 0)
+        {
+            prime = n == smallPrime;
+            return true;
+        }
+
+    prime = true;
+    return n < 17 * 17;
+}
+
+bool IsPrime64 (std::uint64_t n)
+{
+    bool prime;
+
+    if (SettleBySmallPrimes (n, prime))
+        return prime;
+
+    // Standard Miller-Rabin test algorithm, in Montgomery form.
+    Montgomery montgomery (n);
+    std::uint32_t twoAdicValuationExponent = std::countr_zero (n - 1);
+    std::uint64_t oddPartExponent = (n - 1) >> twoAdicValuationExponent;
+    std::uint64_t minusOne = n - montgomery.One ();
+
+    for (std::uint64_t base : deterministicBases)
+    {
+        // A base which is a multiple of 'n' says nothing about 'n'.
+        if (base % n == 0)
+            continue;
+
+        std::uint64_t runningPower = montgomery.Power (montgomery.ToMontgomery (base), oddPartExponent);
+
+        if (runningPower == montgomery.One () || runningPower == minusOne)
+            continue;
+
+        std::uint32_t r = 1;
+
+        for (; r < twoAdicValuationExponent; ++r)
+        {
+            runningPower = montgomery.Multiply (runningPower, runningPower);
+
+            if (runningPower == minusOne)
+                break;
+            else if (runningPower == montgomery.One ())
+                // -1 has not been encountered previously, so the previous power was a non-trivial square root of 1.
+                return false;
+        }
+
+        if (r == twoAdicValuationExponent)
+            return false;
+    }
+
+    return true;
+}
+
+// Calls 'testRange' on contiguous ranges of indices covering [0, 'count') using up to 'threadCount' threads.
+// Range boundaries are multiples of 64, so that no two threads write to the same word of a BitArray.
+template<typename TestRange>
+static void ForEachRange (std::size_t count, std::size_t threadCount, TestRange&& testRange)
+{
+    std::size_t wordCount = (count + 63) / 64;
+    threadCount = std::max (std::size_t (1), std::min (threadCount, wordCount));
+
+    auto testWords = [&] (std::size_t thread)
+    {
+        std::size_t begin = wordCount * thread / threadCount * 64;
+        std::size_t end = std::min (count, wordCount * (thread + 1) / threadCount * 64);
+        testRange (begin, end);
+    };
+
+    std::vector<std::thread> threads;
+
+    for (std::size_t thread = 1; thread < threadCount; ++thread)
+        threads.emplace_back (testWords, thread);
+
+    testWords (0);
+
+    for (std::thread& thread : threads)
+        thread.join ();
+}
+
+// The state of one candidate in a lockstep Miller-Rabin test.
+struct MillerRabinLane
+{
+    // The arithmetic modulo the candidate, which is odd.
+    Montgomery montgomery;
+
+    // The odd part of the candidate minus 1.
+    std::uint64_t oddPartExponent;
+
+    // The 2-adic valuation of the candidate minus 1.
+    std::uint32_t twoAdicValuationExponent;
+
+    // The Montgomery form of -1 modulo the candidate.
+    std::uint64_t minusOne;
+
+    // Constructs the state for the odd candidate 'n' > 1.
+    explicit MillerRabinLane (std::uint64_t n)
+        : montgomery (n),
+        twoAdicValuationExponent (std::countr_zero (n - 1))
+    {
+        oddPartExponent = (n - 1) >> twoAdicValuationExponent;
+        minusOne = n - montgomery.One ();
+    }
+};
+
+// Runs a Miller-Rabin test to 'base' on every lane whose 'alive' flag is set, clearing the flag of each lane
+// for which 'base' witnesses compositeness.
+// The exponentiations share one loop, so that the multiplications of different lanes are independent of each other.
+static void MillerRabinLockstep
+(
+    const std::array<MillerRabinLane, laneCount>& lanes,
+    std::array<bool, laneCount>& alive,
+    std::uint64_t base
+)
+{
+    std::array<std::uint64_t, laneCount> powers;
+    std::array<std::uint64_t, laneCount> squares;
+    std::array<std::uint64_t, laneCount> exponents;
+    std::uint64_t remaining = 0;
+
+    for (std::size_t i = 0; i < laneCount; ++i)
+    {
+        const Montgomery& montgomery = lanes[i].montgomery;
+        powers[i] = montgomery.One ();
+
+        // A base which is a multiple of the candidate says nothing about it, so it leaves that lane at 1.
+        bool skip = !alive[i] || base % montgomery.Modulus () == 0;
+        squares[i] = skip ? 0 : montgomery.ToMontgomery (base);
+        exponents[i] = skip ? 0 : lanes[i].oddPartExponent;
+        remaining |= exponents[i];
+    }
+
+    // Standard binary exponentiation algorithm, one bit of every lane per round.
+    while (remaining != 0)
+    {
+        remaining = 0;
+
+        for (std::size_t i = 0; i < laneCount; ++i)
+        {
+            if (exponents[i] & 1)
+                powers[i] = lanes[i].montgomery.Multiply (powers[i], squares[i]);
+
+            squares[i] = lanes[i].montgomery.Multiply (squares[i], squares[i]);
+            exponents[i] >>= 1;
+            remaining |= exponents[i];
+        }
+    }
+
+    for (std::size_t i = 0; i < laneCount; ++i)
+    {
+        if (!alive[i])
+            continue;
+
+        const Montgomery& montgomery = lanes[i].montgomery;
+        std::uint64_t runningPower = powers[i];
+
+        if (runningPower == montgomery.One () || runningPower == lanes[i].minusOne)
+            continue;
+
+        std::uint32_t r = 1;
+
+        for (; r < lanes[i].twoAdicValuationExponent; ++r)
+        {
+            runningPower = montgomery.Multiply (runningPower, runningPower);
+
+            if (runningPower == lanes[i].minusOne || runningPower == montgomery.One ())
+                break;
+        }
+
+        if (r == lanes[i].twoAdicValuationExponent || runningPower == montgomery.One ())
+            alive[i] = false;
+    }
+}
+
+BitArray MillerRabinBatchTest
+(
+    std::span<const std::uint64_t> candidates,
+    std::span<const std::uint64_t> bases,
+    std::size_t threadCount
+)
+{
+    BitArray results (candidates.size (), false);
+
+    ForEachRange
+    (
+        candidates.size (),
+        threadCount,
+        [&] (std::size_t begin, std::size_t end)
+        {
+            // Fill the lanes with the candidates not settled by small primes.
+            // Idle lanes run on the placeholder modulus 3 and are never alive.
+            std::array<MillerRabinLane, laneCount> lanes
+            {
+                MillerRabinLane (3), MillerRabinLane (3), MillerRabinLane (3), MillerRabinLane (3)
+            };
+            std::array<std::size_t, laneCount> indices;
+            std::size_t filled = 0;
+
+            auto runLanes = [&] ()
+            {
+                std::array<bool, laneCount> alive;
+
+                for (std::size_t i = 0; i < laneCount; ++i)
+                    alive[i] = i < filled;
+
+                for (std::uint64_t base : bases)
+                {
+                    MillerRabinLockstep (lanes, alive, base);
+
+                    if (std::none_of (alive.cbegin (), alive.cend (), [] (bool a) { return a; }))
+                        break;
+                }
+
+                for (std::size_t i = 0; i < filled; ++i)
+                    if (alive[i])
+                        results.Set (indices[i]);
+
+                filled = 0;
+            };
+
+            for (std::size_t index = begin; index < end; ++index)
+            {
+                std::uint64_t n = candidates[index];
+                bool prime;
+
+                if (SettleBySmallPrimes (n, prime))
+                {
+                    if (prime)
+                        results.Set (index);
+
+                    continue;
+                }
+
+                lanes[filled] = MillerRabinLane (n);
+                indices[filled] = index;
+
+                if (++filled == laneCount)
+                    runLanes ();
+            }
+
+            if (filled > 0)
+                runLanes ();
+        }
+    );
+
+    return results;
+}
+
+BitArray MillerRabinBatchTest
+(
+    std::span<const mpz_class> candidates,
+    std::span<const mpz_class> bases,
+    std::size_t threadCount
+)
+{
+    BitArray results (candidates.size (), false);
+
+    ForEachRange
+    (
+        candidates.size (),
+        threadCount,
+        [&] (std::size_t begin, std::size_t end)
+        {
+            for (std::size_t index = begin; index < end; ++index)
+            {
+                const mpz_class& n = candidates[index];
+
+                if (n < 2 || mpz_even_p (n.get_mpz_t ()))
+                {
+                    if (n == 2)
+                        results.Set (index);
+
+                    continue;
+                }
+
+                bool probablePrime = true;
+
+                for (const mpz_class& base : bases)
+                {
+                    // A base which is a multiple of 'n' says nothing about 'n'.
+                    if (mpz_divisible_p (base.get_mpz_t (), n.get_mpz_t ()))
+                        continue;
+
+                    if (!MillerRabinProbabilisticTest (n, base))
+                    {
+                        probablePrime = false;
+                        break;
+                    }
+                }
+
+                if (probablePrime)
+                    results.Set (index);
+            }
+        }
+    );
+
+    return results;
+}
+
+BitArray IsPrime64Batch (std::span<const std::uint64_t> candidates, std::size_t threadCount)
+{
+    return MillerRabinBatchTest (candidates, deterministicBases, threadCount);
+}
@@ -1,14 +1,53 @@
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
 #include <gmpxx.h>
 
+#include "BitArray.h"
+
 // Runs a Fermat probabilistic prime test on 'n' using the given base.
 // 'base' should not be a multiple of 'n'.
 // If 'n' is not a Carmichael number (a set of asymptotic density 0) and composite,
 // at least 50% of bases detect its compositeness.
-bool FermatProbabilisticTest (const mpz_class n, const mpz_class base);
+bool FermatProbabilisticTest (const mpz_class& n, const mpz_class& base);
 
 // Runs a Miller-Rabin probabilistic prime test on 'n' using the given base.
 // 'base' should not be a multiple of 'n', and 'n' should be odd.
 // If 'n' is composite, at least 75% of bases detect its compositeness.
-bool MillerRabinProbabilisticTest (const mpz_class n, const mpz_class base);
+bool MillerRabinProbabilisticTest (const mpz_class& n, const mpz_class& base);
+
+// Returns whether 'n' is prime, using Miller-Rabin tests to a set of seven bases known to admit no composite
+// below 2^64.
+// Runs entirely in machine words; prefer it to the tests above wherever 'n' fits in 64 bits.
+bool IsPrime64 (std::uint64_t n);
+
+// Runs Miller-Rabin probabilistic prime tests to each of 'bases' on every integer in 'candidates'
+// using up to 'threadCount' threads, and returns a BitArray whose bit 'i' is set if 'candidates[i]' passes them all.
+// Testing a candidate stops at the first base to witness its compositeness, and bases which are multiples of a
+// candidate are skipped for it.
+// Candidates below 17^2 or with a prime factor up to 13 are decided exactly by division instead.
+// Four candidates are exponentiated in lockstep at a time, so that their independent multiplications overlap.
+BitArray MillerRabinBatchTest
+(
+    std::span<const std::uint64_t> candidates,
+    std::span<const std::uint64_t> bases,
+    std::size_t threadCount = 1
+);
+
+// Runs Miller-Rabin probabilistic prime tests to each of 'bases' on every integer in 'candidates'
+// using up to 'threadCount' threads, and returns a BitArray whose bit 'i' is set if 'candidates[i]' passes them all.
+// Testing a candidate stops at the first base to witness its compositeness, and bases which are multiples of a
+// candidate are skipped for it; integers below 2 and even integers other than 2 never pass.
+BitArray MillerRabinBatchTest
+(
+    std::span<const mpz_class> candidates,
+    std::span<const mpz_class> bases,
+    std::size_t threadCount = 1
+);
+
+// Returns a BitArray whose bit 'i' is set if 'candidates[i]' is prime, using up to 'threadCount' threads.
+// Equivalent to calling 'IsPrime64' on each candidate.
+BitArray IsPrime64Batch (std::span<const std::uint64_t> candidates, std::size_t threadCount = 1);
@@ -0,0 +1,363 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <numeric>
+#include <thread>
+#include <vector>
+
+#include "Divisors.h"
+#include "Exponent.h"
+#include "PrimePower.h"
+#include "PrimeSieve.h"
+
+// Calls 'visitor' ('n', 'primeFactors') on every positive integer 'n' in ['lowerLimit', 'upperLimit'), where
+// 'primeFactors' is a PrimeFactorsBuffer<T> holding the prime factorization of 'n' in increasing order of primes,
+// valid only for the duration of the call; 0, having no prime factorization, is skipped.
+// The range is factored by a segmented sieve which divides every base prime up to the square root of 'upperLimit'
+// out of its multiples in each segment, leaving at most one larger prime per integer.
+// Each of up to 'threadCount' threads visits a contiguous run of segments in increasing order, so 'visitor' may be
+// called concurrently and must be safe to call so; progress is optionally output to 'clog'.
+template<std::unsigned_integral T, typename Visitor>
+void ForEachFactorization
+(
+    T lowerLimit,
+    T upperLimit,
+    Visitor&& visitor,
+    bool verbose = false,
+    std::size_t threadCount = 1
+)
+{
+    // The number of integers factored at a time, chosen so that the working arrays of a segment stay in cache.
+    constexpr T segmentSize = T (1) << 15;
+
+    // Every prime divides 0, so it would never be divided out.
+    if (lowerLimit == 0)
+        lowerLimit = 1;
+
+    if (lowerLimit >= upperLimit)
+        return;
+
+    // The base primes up to the square root of the last integer; the shared vector outlives 'baseSieve'.
+    PrimeSieve<T> baseSieve (upperLimit < 2 ? 0 : IntegerSqrt (upperLimit - 1) + 1, false, threadCount);
+    std::shared_ptr<const std::vector<T>> basePrimes = baseSieve.Primes ();
+
+    T segmentCount = (upperLimit - lowerLimit + segmentSize - 1) / segmentSize;
+    threadCount = std::max (std::size_t (1), std::min (threadCount, std::size_t (segmentCount)));
+    std::mutex clogMutex;
+
+    auto factorSegments = [&] (std::size_t thread)
+    {
+        // The part of each integer not yet divided out, then the base primes dividing it and their powers,
+        // in slots of 'maximumPrimeFactorCount' per integer.
+        std::vector<T> residuals (segmentSize);
+        std::vector<std::uint8_t> counts (segmentSize);
+        std::vector<std::uint32_t> primes (segmentSize * maximumPrimeFactorCount);
+        std::vector<std::uint8_t> powers (segmentSize * maximumPrimeFactorCount);
+        PrimeFactorsBuffer<T> primeFactors;
+
+        // The position relative to 'lowerLimit' of the next multiple of each base prime to divide out,
+        // carried over from one segment to the next; base primes are added once their square reaches the segment.
+        std::vector<T> nextMultiples;
+
+        T firstSegment = T (segmentCount * thread / threadCount);
+        T lastSegment = T (segmentCount * (thread + 1) / threadCount);
+
+        for (T segment = firstSegment; segment < lastSegment; ++segment)
+        {
+            T segmentOffset = segment * segmentSize;
+            T segmentStart = lowerLimit + segmentOffset;
+            T segmentEnd = upperLimit - segmentStart > segmentSize ? segmentStart + segmentSize : upperLimit;
+            T length = segmentEnd - segmentStart;
+
+            if (verbose)
+            {
+                std::lock_guard<std::mutex> lock (clogMutex);
+                std::clog << "Factoring [" << segmentStart << ", " << segmentEnd << ")\n";
+            }
+
+            for (T i = 0; i < length; ++i)
+            {
+                residuals[i] = segmentStart + i;
+                counts[i] = 0;
+            }
+
+            // Work on offsets into the segment, so that nothing overflows for ranges just below the maximum of 'T'.
+            for (std::size_t j = nextMultiples.size (); j < basePrimes->size (); ++j)
+            {
+                T prime = (*basePrimes)[j];
+
+                if (prime > (segmentEnd - 1) / prime)
+                    break;
+
+                nextMultiples.emplace_back (segmentOffset + (prime - segmentStart % prime) % prime);
+            }
+
+            for (std::size_t j = 0; j < nextMultiples.size (); ++j)
+            {
+                T prime = (*basePrimes)[j];
+                T offset = nextMultiples[j] - segmentOffset;
+
+                if (offset >= length)
+                    continue;
+
+                // Dividing by an odd prime is replaced by multiplying by its inverse modulo 2^bits, which gives the
+                // exact quotient of any multiple of it; a product at most 'bound' then also shows divisibility.
+                // Newton's iteration doubles the number of correct low bits each time, and 'prime' is its own
+                // inverse modulo 8.
+                T inverse = prime;
+                T bound = T (-1) / prime;
+
+                for (int i = 0; i < 6; ++i)
+                    inverse *= 2 - prime * inverse;
+
+                for (; offset < length; offset += prime)
+                {
+                    T residual = residuals[offset];
+                    std::uint8_t power = 0;
+
+                    if (prime == 2)
+                    {
+                        power = std::uint8_t (std::countr_zero (residual));
+                        residual >>= power;
+                    }
+                    else
+                        do
+                        {
+                            residual *= inverse;
+                            ++power;
+                        }
+                        while (T (residual * inverse) <= bound);
+
+                    residuals[offset] = residual;
+                    std::size_t slot = offset * maximumPrimeFactorCount + counts[offset]++;
+                    primes[slot] = std::uint32_t (prime);
+                    powers[slot] = power;
+                }
+
+                nextMultiples[j] = segmentOffset + offset;
+            }
+
+            // Whatever remains of each integer is 1 or a single prime larger than every base prime dividing it.
+            for (T i = 0; i < length; ++i)
+            {
+                primeFactors.clear ();
+                std::size_t firstSlot = i * maximumPrimeFactorCount;
+
+                for (std::size_t slot = firstSlot; slot < firstSlot + counts[i]; ++slot)
+                    primeFactors.emplace_back (primes[slot], powers[slot]);
+
+                if (residuals[i] > 1)
+                    primeFactors.emplace_back (residuals[i], 1);
+
+                visitor (segmentStart + i, primeFactors);
+            }
+        }
+    };
+
+    std::vector<std::thread> threads;
+
+    for (std::size_t thread = 1; thread < threadCount; ++thread)
+        threads.emplace_back (factorSegments, thread);
+
+    factorSegments (0);
+
+    for (std::thread& thread : threads)
+        thread.join ();
+}
+
+// The values of the common arithmetic functions of Factorization on every integer in a range of positive integers
+// ['lowerLimit', 'upperLimit'), computed in one pass of ForEachFactorization and stored one column per function.
+template<std::unsigned_integral T>
+class RangeFactorization
+{
+private:
+    // The inclusive lower bound on the range.
+    T lowerLimit;
+
+    // The exclusive upper bound on the range.
+    T upperLimit;
+
+    // The number of factors of each integer.
+    std::vector<factor_count_t<T>> tau;
+
+    // The sum of the factors of each integer, modulo 2^64.
+    std::vector<std::uint64_t> sigma;
+
+    // The totient of each integer.
+    std::vector<T> totient;
+
+    // The Moebius function of each integer.
+    std::vector<std::int8_t> mu;
+
+    // The Liouville function of each integer.
+    std::vector<std::int8_t> liouville;
+
+    // The number of distinct prime factors of each integer.
+    std::vector<std::uint8_t> smallOmega;
+
+    // The number of prime factors of each integer with multiplicity.
+    std::vector<std::uint8_t> bigOmega;
+
+    // The radical of each integer.
+    std::vector<T> radical;
+
+    // The Carmichael function of each integer.
+    std::vector<T> carmichael;
+
+public:
+    // Constructs a RangeFactorization over ['lowerLimit', 'upperLimit') using up to 'threadCount' threads
+    // and optionally outputs progress to 'clog'.
+    // If 'lowerLimit' is 0, every value at 0 is left as 0.
+    RangeFactorization (T lowerLimit, T upperLimit, bool verbose = false, std::size_t threadCount = 1)
+        : lowerLimit (lowerLimit),
+        upperLimit (upperLimit),
+        tau (upperLimit - lowerLimit),
+        sigma (upperLimit - lowerLimit),
+        totient (upperLimit - lowerLimit),
+        mu (upperLimit - lowerLimit),
+        liouville (upperLimit - lowerLimit),
+        smallOmega (upperLimit - lowerLimit),
+        bigOmega (upperLimit - lowerLimit),
+        radical (upperLimit - lowerLimit),
+        carmichael (upperLimit - lowerLimit)
+    {
+        // Every thread writes to its own entries of each column.
+        ForEachFactorization
+        (
+            lowerLimit,
+            upperLimit,
+            [this] (T n, const PrimeFactorsBuffer<T>& primeFactors)
+            {
+                factor_count_t<T> nTau = 1;
+                std::uint64_t nSigma = 1;
+                T nTotient = 1;
+                std::uint8_t nBigOmega = 0;
+                bool squarefree = true;
+                T nRadical = 1;
+                T nCarmichael = 1;
+
+                for (const auto& primePower : primeFactors)
+                {
+                    T prime = primePower.prime;
+
+                    // Standard product forms of the divisor counting, divisor sum and totient functions.
+                    std::uint64_t powerSum = 1;
+                    std::uint64_t power = 1;
+                    T previousPower = 1;
+
+                    for (std::uint32_t k = 0; k < primePower.power; ++k)
+                    {
+                        previousPower = T (power);
+                        power *= prime;
+                        powerSum += power;
+                    }
+
+                    nTau *= primePower.power + 1;
+                    nSigma *= powerSum;
+                    nTotient *= previousPower * (prime - 1);
+                    nBigOmega += primePower.power;
+                    squarefree = squarefree && primePower.power == 1;
+                    nRadical *= prime;
+
+                    // Standard product representation of Carmichael function.
+                    T exponent;
+
+                    if (prime == 2)
+                        exponent = primePower.power < 3 ? primePower.power : previousPower / 2;
+                    else
+                        exponent = previousPower * (prime - 1);
+
+                    nCarmichael = nCarmichael == 1 ? exponent : std::lcm (nCarmichael, exponent);
+                }
+
+                std::size_t index = n - this->lowerLimit;
+                tau[index] = nTau;
+                sigma[index] = nSigma;
+                totient[index] = nTotient;
+
+                // Efficient (-1)^n algorithm.
+                mu[index] = squarefree ? std::int8_t ((-(primeFactors.size () & 1)) | 1) : 0;
+                liouville[index] = std::int8_t ((-(nBigOmega & 1)) | 1);
+                smallOmega[index] = std::uint8_t (primeFactors.size ());
+                bigOmega[index] = nBigOmega;
+                radical[index] = nRadical;
+                carmichael[index] = nCarmichael;
+            },
+            verbose,
+            threadCount
+        );
+    }
+
+    // Returns the number of factors of 'n', if 'n' is in ['lowerLimit', 'upperLimit').
+    // Out of range arguments result in undefined behaviour.
+    factor_count_t<T> Tau (T n) const
+    {
+        return tau[n - lowerLimit];
+    }
+
+    // Returns the sum of the factors of 'n' modulo 2^64, if 'n' is in ['lowerLimit', 'upperLimit').
+    // Out of range arguments result in undefined behaviour.
+    std::uint64_t Sigma1 (T n) const
+    {
+        return sigma[n - lowerLimit];
+    }
+
+    // Returns the number of integers in [0, 'n') coprime to 'n', if 'n' is in ['lowerLimit', 'upperLimit').
+    // Out of range arguments result in undefined behaviour.
+    T Totient (T n) const
+    {
+        return totient[n - lowerLimit];
+    }
+
+    // Returns 0 if 'n' is not squarefree, 1 if 'n' has an even number of prime factors, and -1 otherwise,
+    // if 'n' is in ['lowerLimit', 'upperLimit').
+    // Out of range arguments result in undefined behaviour.
+    std::int32_t MoebiusFunction (T n) const
+    {
+        return mu[n - lowerLimit];
+    }
+
+    // Returns -1 to the power of the number of prime factors of 'n' with multiplicity,
+    // if 'n' is in ['lowerLimit', 'upperLimit').
+    // Out of range arguments result in undefined behaviour.
+    std::int32_t LiouvilleFunction (T n) const
+    {
+        return liouville[n - lowerLimit];
+    }
+
+    // Returns the number of distinct prime factors of 'n', if 'n' is in ['lowerLimit', 'upperLimit').
+    // Out of range arguments result in undefined behaviour.
+    std::uint32_t SmallOmega (T n) const
+    {
+        return smallOmega[n - lowerLimit];
+    }
+
+    // Returns the number of prime factors of 'n' with multiplicity, if 'n' is in ['lowerLimit', 'upperLimit').
+    // Out of range arguments result in undefined behaviour.
+    std::uint32_t BigOmega (T n) const
+    {
+        return bigOmega[n - lowerLimit];
+    }
+
+    // Returns the radical of 'n', if 'n' is in ['lowerLimit', 'upperLimit').
+    // Out of range arguments result in undefined behaviour.
+    T Radical (T n) const
+    {
+        return radical[n - lowerLimit];
+    }
+
+    // Returns the least common multiple of the multiplicative orders of the integers in [0, 'n') coprime to 'n',
+    // if 'n' is in ['lowerLimit', 'upperLimit').
+    // Out of range arguments result in undefined behaviour.
+    T CarmichaelFunction (T n) const
+    {
+        return carmichael[n - lowerLimit];
+    }
+};
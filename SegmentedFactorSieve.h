@@ -0,0 +1,323 @@
+#pragma once
+
+#include <algorithm>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <thread>
+#include <vector>
+
+#include "Divisors.h"
+#include "Exponent.h"
+#include "PrimePower.h"
+#include "PrimeSieve.h"
+
+// A segmented Eratosthenes-type sieve for computing the least prime factor for a range of positive integers
+// ['lowerLimit', 'upperLimit'), which need not start near 0.
+// The whole range is held in memory, by default as a table of 4 bytes per integer.
+// Optionally, every base prime up to the square root of each segment is instead recorded against each of its multiples
+// there, so that prime factorizations are read off rather than found by trial division, at 4 bytes per integer
+// plus 4 bytes per base prime dividing it: about 16 bytes per integer near 10^12.
+// To factor a range too large for either, ForEachFactorization streams it one segment at a time.
+template<std::unsigned_integral T>
+class SegmentedFactorSieve
+{
+private:
+    // The number of integers sieved at a time, chosen so that each segment of the tables stays resident in cache.
+    static constexpr T segmentSize = T (1) << 16;
+
+    // Unless prime factors are indexed, the underlying lookup table, holding at index 'n' - 'lowerLimit' the least
+    // prime factor of 'n' if 'n' is composite and 0 otherwise.
+    std::vector<std::uint32_t> sieve;
+
+    // If prime factors are indexed, the base primes dividing each integer of each segment in turn, one vector
+    // per segment, each in increasing order.
+    std::vector<std::vector<std::uint32_t>> segmentPrimes;
+
+    // If prime factors are indexed, at index 'n' - 'lowerLimit', the position in the vector of the segment of 'n'
+    // just past the base primes dividing 'n'; those of 'n' start where those of 'n' - 1 end, or at 0 at the start
+    // of a segment.
+    std::vector<std::uint32_t> ends;
+
+    // The inclusive lower bound on the lookup table.
+    T lowerLimit;
+
+    // The exclusive upper bound on the lookup table.
+    T upperLimit;
+
+    // Whether the base prime factors of every integer are recorded.
+    bool indexPrimeFactors;
+
+    // The primes up to the square root of the largest integer in the window.
+    std::shared_ptr<const std::vector<T>> basePrimes;
+
+    // Returns the base primes dividing 'n' in increasing order, if prime factors are indexed
+    // and 'n' is in ['lowerLimit', 'upperLimit').
+    std::span<const std::uint32_t> BasePrimeFactors (T n) const
+    {
+        T index = n - lowerLimit;
+        const std::vector<std::uint32_t>& primes = segmentPrimes[index / segmentSize];
+        std::uint32_t begin = index % segmentSize == 0 ? 0 : ends[index - 1];
+        return { primes.data () + begin, primes.data () + ends[index] };
+    }
+
+public:
+    // Constructs a SegmentedFactorSieve over ['lowerLimit', 'upperLimit') using up to 'threadCount' threads
+    // and optionally outputs progress to 'clog'.
+    // If 'indexPrimeFactors' is set, the base prime factors of every integer are recorded, so that 'PrimeFactors'
+    // costs about as much as that of FactorSieve, at about four times the memory.
+    SegmentedFactorSieve
+    (
+        T lowerLimit,
+        T upperLimit,
+        bool verbose = false,
+        std::size_t threadCount = 1,
+        bool indexPrimeFactors = false
+    )
+        : sieve (indexPrimeFactors ? 0 : upperLimit - lowerLimit, 0),
+        segmentPrimes (indexPrimeFactors ? (upperLimit - lowerLimit + segmentSize - 1) / segmentSize : 0),
+        ends (indexPrimeFactors ? upperLimit - lowerLimit : 0, 0),
+        lowerLimit (lowerLimit),
+        upperLimit (upperLimit),
+        indexPrimeFactors (indexPrimeFactors)
+    {
+        // The shared vector of base primes outlives 'baseSieve'.
+        PrimeSieve<T> baseSieve (upperLimit < 2 ? 0 : IntegerSqrt (upperLimit - 1) + 1, false, threadCount);
+        basePrimes = baseSieve.Primes ();
+
+        // Each thread is handed a contiguous run of segments, and each segment is marked by every base prime
+        // in increasing order, so that the first prime to mark an integer is its least prime factor.
+        T segmentCount = (upperLimit - lowerLimit + segmentSize - 1) / segmentSize;
+        threadCount = std::max (std::size_t (1), std::min (threadCount, std::size_t (segmentCount)));
+        std::mutex clogMutex;
+
+        auto sieveSegments = [&] (std::size_t thread)
+        {
+            // The position relative to 'lowerLimit' of the next multiple of each base prime to mark,
+            // carried over from one segment to the next; base primes are added once their square reaches the segment.
+            std::vector<T> nextMultiples;
+
+            T firstSegment = T (segmentCount * thread / threadCount);
+            T lastSegment = T (segmentCount * (thread + 1) / threadCount);
+
+            for (T segment = firstSegment; segment < lastSegment; ++segment)
+            {
+                T segmentOffset = segment * segmentSize;
+                T segmentStart = lowerLimit + segmentOffset;
+                T segmentEnd = upperLimit - segmentStart > segmentSize ? segmentStart + segmentSize : upperLimit;
+                T length = segmentEnd - segmentStart;
+
+                if (verbose)
+                {
+                    std::lock_guard<std::mutex> lock (clogMutex);
+                    std::clog << "Sieving [" << segmentStart << ", " << segmentEnd << ")\n";
+                }
+
+                // Work on offsets into the segment, so that nothing overflows for windows just below the maximum of 'T'.
+                // 0 is a multiple of every prime, but has no prime factors, so it is skipped.
+                for (std::size_t j = nextMultiples.size (); j < basePrimes->size (); ++j)
+                {
+                    T prime = (*basePrimes)[j];
+
+                    if (prime > (segmentEnd - 1) / prime)
+                        break;
+
+                    nextMultiples.emplace_back
+                    (
+                        segmentOffset + (segmentStart == 0 ? prime : (prime - segmentStart % prime) % prime)
+                    );
+                }
+
+                if (!indexPrimeFactors)
+                {
+                    // A prime in the window marks itself, which reads back the same as being left at 0.
+                    std::uint32_t* segmentSieve = sieve.data () + segmentOffset;
+
+                    for (std::size_t j = 0; j < nextMultiples.size (); ++j)
+                    {
+                        T prime = (*basePrimes)[j];
+                        T offset = nextMultiples[j] - segmentOffset;
+
+                        for (; offset < length; offset += prime)
+                            if (segmentSieve[offset] == 0)
+                                segmentSieve[offset] = std::uint32_t (prime);
+
+                        nextMultiples[j] = segmentOffset + offset;
+                    }
+
+                    continue;
+                }
+
+                // Count the base primes dividing each integer, turn the counts into the positions where the primes
+                // of each integer start, then write each prime at the position of each multiple and advance it,
+                // which leaves it at the end of the primes of that integer.
+                std::uint32_t* segmentEnds = ends.data () + segmentOffset;
+
+                for (std::size_t j = 0; j < nextMultiples.size (); ++j)
+                    for (T offset = nextMultiples[j] - segmentOffset; offset < length; offset += (*basePrimes)[j])
+                        ++segmentEnds[offset];
+
+                std::uint32_t position = 0;
+
+                for (T i = 0; i < length; ++i)
+                {
+                    std::uint32_t count = segmentEnds[i];
+                    segmentEnds[i] = position;
+                    position += count;
+                }
+
+                std::vector<std::uint32_t>& primes = segmentPrimes[segment];
+                primes.resize (position);
+
+                for (std::size_t j = 0; j < nextMultiples.size (); ++j)
+                {
+                    T prime = (*basePrimes)[j];
+                    T offset = nextMultiples[j] - segmentOffset;
+
+                    for (; offset < length; offset += prime)
+                        primes[segmentEnds[offset]++] = std::uint32_t (prime);
+
+                    nextMultiples[j] = segmentOffset + offset;
+                }
+            }
+        };
+
+        std::vector<std::thread> threads;
+
+        for (std::size_t thread = 1; thread < threadCount; ++thread)
+            threads.emplace_back (sieveSegments, thread);
+
+        sieveSegments (0);
+
+        for (std::thread& thread : threads)
+            thread.join ();
+    }
+
+    // Returns the least prime factor of 'n', if 'n' is in ['lowerLimit', 'upperLimit').
+    // Out of range arguments result in undefined behaviour.
+    T LeastPrimeFactor (T n) const
+    {
+        if (indexPrimeFactors)
+        {
+            std::span<const std::uint32_t> basePrimeFactors = BasePrimeFactors (n);
+            return basePrimeFactors.empty () ? n : basePrimeFactors.front ();
+        }
+
+        std::uint32_t leastPrimeFactor = sieve[n - lowerLimit];
+        return leastPrimeFactor == 0 ? n : leastPrimeFactor;
+    }
+
+    // Returns the prime factorization of 'n', if 'n' is in ['lowerLimit', 'upperLimit').
+    // Out of range arguments result in undefined behaviour.
+    std::vector<PrimePower<T, std::uint32_t>> PrimeFactors (T n) const
+    {
+        std::vector<PrimePower<T, std::uint32_t>> primeFactors;
+        PrimeFactors (n, primeFactors);
+        return primeFactors;
+    }
+
+    // Writes into 'primeFactors' the prime factorization of 'n', if 'n' is in ['lowerLimit', 'upperLimit').
+    // 'primeFactors' is cleared first, and may be any container with 'clear', 'emplace_back' and 'back',
+    // such as a reused std::vector or a PrimeFactorsBuffer, so that no allocation takes place.
+    // Unless prime factors are indexed, the cofactor of the least prime factor is found by trial division,
+    // which takes tens of microseconds near 10^12 and hundreds near 10^15.
+    // Out of range arguments result in undefined behaviour.
+    template<typename Container>
+    void PrimeFactors (T n, Container& primeFactors) const
+    {
+        primeFactors.clear ();
+
+        if (indexPrimeFactors)
+        {
+            // An integer with no base prime factors is 1 or prime.
+            std::span<const std::uint32_t> basePrimeFactors = BasePrimeFactors (n);
+
+            if (basePrimeFactors.empty ())
+            {
+                primeFactors.emplace_back (n, 1);
+                return;
+            }
+
+            for (std::uint32_t prime : basePrimeFactors)
+            {
+                primeFactors.emplace_back (prime, 0);
+
+                do
+                {
+                    ++primeFactors.back ().power;
+                    n /= prime;
+                }
+                while (n % prime == 0);
+            }
+
+            // Only base primes up to the square root of the segment of 'n' are recorded, so whatever remains
+            // is 1 or a single prime greater than the square root of 'n'.
+            if (n > 1)
+                primeFactors.emplace_back (n, 1);
+
+            return;
+        }
+
+        // Divide out the least prime factor of 'n', looked up in the table.
+        T prime = LeastPrimeFactor (n);
+        primeFactors.emplace_back (prime, 1);
+
+        if (prime <= 1)
+            return;
+
+        n /= prime;
+
+        while (n % prime == 0)
+        {
+            ++primeFactors.back ().power;
+            n /= prime;
+        }
+
+        // The remaining cofactor generally lies outside the window,
+        // so its prime factors are found by trial division by the base primes beyond 'prime'.
+        for
+        (
+            auto nextPrime = std::upper_bound (basePrimes->cbegin (), basePrimes->cend (), prime);
+            nextPrime != basePrimes->cend () && *nextPrime <= n / *nextPrime;
+            ++nextPrime
+        )
+        {
+            if (n % *nextPrime != 0)
+                continue;
+
+            primeFactors.emplace_back (*nextPrime, 0);
+
+            while (n % *nextPrime == 0)
+            {
+                ++primeFactors.back ().power;
+                n /= *nextPrime;
+            }
+        }
+
+        // Whatever remains is 1 or a single prime greater than the square root of the cofactor.
+        if (n > 1)
+            primeFactors.emplace_back (n, 1);
+    }
+
+    // Returns the factors of 'n' in increasing order, if 'n' is in ['lowerLimit', 'upperLimit').
+    // Out of range arguments result in undefined behaviour.
+    std::vector<T> Factors (T n) const
+    {
+        return GenerateFactors (PrimeFactors (n));
+    }
+
+    // Writes into 'factors' the factors of 'n' in increasing order, if 'n' is in ['lowerLimit', 'upperLimit'),
+    // using 'buffer' as scratch space.
+    // Both vectors may be reused across calls so that their storage is only allocated once.
+    // Out of range arguments result in undefined behaviour.
+    void Factors (T n, std::vector<T>& factors, std::vector<T>& buffer) const
+    {
+        PrimeFactorsBuffer<T> primeFactors;
+        PrimeFactors (n, primeFactors);
+        GenerateFactors (primeFactors, factors, buffer);
+    }
+};
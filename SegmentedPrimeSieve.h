@@ -0,0 +1,175 @@
+#pragma once
+
+#include <algorithm>
+#include <concepts>
+#include <cstddef>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+#include "BitArray.h"
+#include "Exponent.h"
+#include "Presieve.h"
+#include "PrimeSieve.h"
+
+// A segmented Eratosthenes prime sieve.
+// Only the primes up to the square root of the limit and a count of primes per segment are kept,
+// so memory grows with the square root of the limit rather than with the limit itself.
+template<std::unsigned_integral T>
+class SegmentedPrimeSieve
+{
+private:
+    // The minimum number of integers in each segment, chosen so that a segment stays resident in cache.
+    static constexpr T minimumSegmentSize = T (1) << 18;
+
+    // The exclusive upper bound on the numbers sieved.
+    T limit;
+
+    // The number of integers in each segment, a multiple of 128 so that each segment starts on a word boundary
+    // of the presieve pattern.
+    T segmentSize;
+
+    // The sieve containing every prime whose multiples need to be struck out of a segment.
+    PrimeSieve<T> baseSieve;
+
+    // The number of primes in [0, 'i' * 'segmentSize') at index 'i'.
+    std::vector<std::size_t> segmentCounts;
+
+    // Strikes out of 'segment' the odd composites in ['segmentStart', 'segmentEnd'), where 'segmentStart' is even
+    // and bit 'i' of 'segment' represents the odd number 'segmentStart' + 2 * 'i' + 1.
+    void SieveSegment (T segmentStart, T segmentEnd, BitArray& segment) const
+    {
+        // Segments starting on a word boundary of the presieve pattern have the multiples of the smallest primes
+        // stamped over them; any other segment has them struck out along with the other base primes.
+        bool presieved = segmentStart % 128 == 0;
+
+        if (presieved)
+        {
+            OddPresievePattern ().Apply (segment, 0, segment.Count (), segmentStart / 2);
+
+            for (std::uint64_t prime : OddPresievePrimes ())
+                if (segmentStart <= prime && prime < segmentEnd)
+                    segment.Set ((prime - segmentStart) / 2);
+        }
+
+        if (segmentStart == 0)
+            segment.Reset (0);
+
+        // Only odd multiples of each odd prime are struck out, so successive multiples are 'prime' apart in 'segment'.
+        for (T prime : *baseSieve.Primes ())
+        {
+            if (prime == 2 || (presieved && prime <= OddPresievePrimes ().back ()))
+                continue;
+
+            if (prime * prime >= segmentEnd)
+                break;
+
+            T firstMultiple = std::max (prime * prime, (segmentStart + prime - 1) / prime * prime);
+
+            if (firstMultiple % 2 == 0)
+                firstMultiple += prime;
+
+            segment.ResetStride ((firstMultiple - segmentStart) / 2, (segmentEnd - segmentStart) / 2, prime);
+        }
+    }
+
+    // Calls 'visitor' on each prime in ['start', 'end') in increasing order.
+    template<typename Visitor>
+    void VisitPrimes (T start, T end, Visitor&& visitor) const
+    {
+        if (start <= 2 && 2 < end && 2 < limit)
+            visitor (T (2));
+
+        for (T segmentStart = start / segmentSize * segmentSize; segmentStart < end; segmentStart += segmentSize)
+        {
+            T segmentEnd = limit - segmentStart > segmentSize ? segmentStart + segmentSize : limit;
+            BitArray segment (segmentSize / 2, true);
+            SieveSegment (segmentStart, segmentEnd, segment);
+
+            // Scan the odd numbers in the segment lying in ['start', 'end') a word at a time.
+            T scanEnd = (std::min (segmentEnd, end) - segmentStart) / 2;
+
+            for (T i = segment.FindNextSet (std::max (start, segmentStart) / 2 - segmentStart / 2);
+                i < scanEnd;
+                i = segment.FindNextSet (i + 1))
+                visitor (segmentStart + 2 * i + 1);
+        }
+    }
+
+public:
+    // Constructs a SegmentedPrimeSieve over [0, 'limit') and optionally outputs progress to 'clog'.
+    SegmentedPrimeSieve (T limit, bool verbose = false)
+        : limit (limit),
+        segmentSize (std::max (minimumSegmentSize, T (IntegerSqrt (limit) + 127) / 128 * 128)),
+        baseSieve (limit < 2 ? 0 : IntegerSqrt (limit - 1) + 1)
+    {
+        // One pass over every segment to record the number of primes preceding each segment.
+        std::size_t count = limit > 2 ? 1 : 0;
+        segmentCounts.emplace_back (0);
+
+        for (T segmentStart = 0; segmentStart < limit; segmentStart += segmentSize)
+        {
+            T segmentEnd = limit - segmentStart > segmentSize ? segmentStart + segmentSize : limit;
+
+            if (verbose)
+                std::clog << "Sieving [" << segmentStart << ", " << segmentEnd << ")\n";
+
+            BitArray segment (segmentSize / 2, true);
+            SieveSegment (segmentStart, segmentEnd, segment);
+
+            count += segment.CountSet (0, (segmentEnd - segmentStart) / 2);
+
+            segmentCounts.emplace_back (count);
+
+            if (segmentEnd == limit)
+                break;
+        }
+    }
+
+    // Returns the primes in [0, 'limit').
+    // The list is regenerated on every call and occupies memory proportional to the number of primes.
+    std::shared_ptr<const std::vector<T>> Primes () const
+    {
+        auto primes = std::make_shared<std::vector<T>> ();
+        primes->reserve (Count ());
+        VisitPrimes (0, limit, [&primes] (T prime) { primes->emplace_back (prime); });
+        return primes;
+    }
+
+    // Calls 'visitor' on each prime in [0, 'limit') in increasing order, one segment at a time.
+    template<typename Visitor>
+    void ForEachPrime (Visitor&& visitor) const
+    {
+        VisitPrimes (0, limit, visitor);
+    }
+
+    // Returns the number of primes in [0, 'limit').
+    std::size_t Count () const
+    {
+        return segmentCounts.back ();
+    }
+
+    // Returns the number of primes in [0, 'n'], if 'n' is in [0, 'limit').
+    // Out of range arguments result in undefined behaviour.
+    std::size_t PrimePi (T n) const
+    {
+        // Look up the count preceding the segment containing 'n', then sieve that segment up to 'n'.
+        T segmentStart = n / segmentSize * segmentSize;
+        std::size_t count = segmentCounts[n / segmentSize];
+        VisitPrimes (segmentStart, n + 1, [&count] (T) { ++count; });
+        return count;
+    }
+
+    // Returns whether 'n' is prime, if 'n' is in [0, 'limit').
+    // Out of range arguments result in undefined behaviour.
+    bool IsPrime (T n) const
+    {
+        if (n % 2 == 0)
+            return n == 2;
+
+        // Sieving the single odd integer 'n' reduces to trial division by the odd base primes.
+        BitArray segment (1, true);
+        SieveSegment (n - 1, n + 1, segment);
+        return segment.Get (0);
+    }
+};
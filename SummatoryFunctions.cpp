@@ -0,0 +1,329 @@
+#include "SummatoryFunctions.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "Exponent.h"
+#include "PrimeSieve.h"
+
+/*
+* Both summatory functions S are evaluated by the Dirichlet hyperbola method.
+* Summing f * 1 over [1, 'v'] for f the Moebius function gives 1, since mu * 1 is 1 only at 1,
+* and for f the Liouville function gives floor (sqrt ('v')), since lambda * 1 is 1 exactly at the squares, so
+* S ('v') = G ('v') - sum of S ('v' / 'd') over 'd' in [2, 'v'], with G ('v') either 1 or floor (sqrt ('v')).
+* Every argument met in the recursion for 'n' is 'n' / 'k' for some 'k'. Those for 'k' up to about the cube root of
+* 'n' are evaluated by the recursion, largest 'k' first, and the rest, all below about 'n' to the power 2/3,
+* are read off a segmented sieve of mu and lambda run once in increasing order.
+*/
+
+// The bound below which the sieve simply runs up to 'n'.
+static constexpr std::uint64_t directLimit = std::uint64_t (1) << 20;
+
+// The number of integers sieved at a time, chosen so that the working arrays of a segment stay in cache.
+static constexpr std::uint64_t segmentSize = std::uint64_t (1) << 16;
+
+// The values of both summatory functions at one argument.
+struct SummatoryValues
+{
+    // The Mertens function.
+    std::int64_t mertens;
+
+    // The summatory Liouville function.
+    std::int64_t liouville;
+};
+
+// Computes mu and lambda of every integer in ['start', 'end') into 'mu' and 'lambda', where 'start' is positive
+// and 'basePrimes' holds every prime whose square is less than 'end'.
+// 'products' is working storage for the part of each integer factored so far.
+static void SieveSegment
+(
+    std::uint64_t start,
+    std::uint64_t end,
+    const std::vector<std::uint64_t>& basePrimes,
+    std::vector<std::uint64_t>& products,
+    std::vector<std::int8_t>& mu,
+    std::vector<std::int8_t>& lambda
+)
+{
+    std::uint64_t length = end - start;
+    std::fill (products.begin (), products.begin () + length, 1);
+    std::fill (mu.begin (), mu.begin () + length, 1);
+    std::fill (lambda.begin (), lambda.begin () + length, 1);
+
+    // Each multiple of each power of each base prime gains a factor of the prime, flipping lambda,
+    // and mu is flipped by the first power and cleared by the second.
+    for (std::uint64_t prime : basePrimes)
+    {
+        if (prime > (end - 1) / prime)
+            break;
+
+        std::uint32_t power = 1;
+
+        for (std::uint64_t primePower = prime; ; primePower *= prime, ++power)
+        {
+            for (std::uint64_t i = (primePower - start % primePower) % primePower; i < length; i += primePower)
+            {
+                products[i] *= prime;
+                lambda[i] = -lambda[i];
+
+                if (power == 1)
+                    mu[i] = -mu[i];
+                else if (power == 2)
+                    mu[i] = 0;
+            }
+
+            if (primePower > (end - 1) / prime)
+                break;
+        }
+    }
+
+    // Whatever is left of each integer is 1 or a single prime greater than every base prime used.
+    for (std::uint64_t i = 0; i < length; ++i)
+        if (products[i] != start + i)
+        {
+            mu[i] = -mu[i];
+            lambda[i] = -lambda[i];
+        }
+}
+
+// Returns the summatory functions of 'n' by sieving [1, 'n'] in full.
+static SummatoryValues SumDirectly (std::uint64_t n)
+{
+    std::vector<std::uint64_t> basePrimes = *PrimeSieve<std::uint64_t> (IntegerSqrt (n) + 1).Primes ();
+    std::vector<std::uint64_t> products (segmentSize);
+    std::vector<std::int8_t> mu (segmentSize);
+    std::vector<std::int8_t> lambda (segmentSize);
+    SummatoryValues sums { 0, 0 };
+
+    for (std::uint64_t segmentStart = 1; segmentStart <= n; segmentStart += segmentSize)
+    {
+        std::uint64_t segmentEnd = std::min (n, segmentStart + segmentSize - 1) + 1;
+        SieveSegment (segmentStart, segmentEnd, basePrimes, products, mu, lambda);
+
+        for (std::uint64_t i = 0; i < segmentEnd - segmentStart; ++i)
+        {
+            sums.mertens += mu[i];
+            sums.liouville += lambda[i];
+        }
+    }
+
+    return sums;
+}
+
+// Returns the summatory functions of 'n', which must be at least 'directLimit', using up to 'threadCount' threads.
+static SummatoryValues SumByHyperbola (std::uint64_t n, std::size_t threadCount)
+{
+    // The arguments 'n' / 'k' for 'k' in [1, 'bigCount'] are evaluated by the recursion.
+    // Of the rest, those for 'k' up to 'sparseEnd' exceed 'root' and are recorded individually while sieving,
+    // and those for greater 'k' are at most 'root' and are recorded for every integer up to 'root'.
+    std::uint64_t bigCount = IntegerRoot (n, 3);
+    std::uint64_t root = IntegerSqrt (n);
+    std::uint64_t sparseEnd = n / (root + 1);
+    std::uint64_t sieveLimit = n / (bigCount + 1);
+
+    std::vector<std::int32_t> denseMertens (root + 1, 0);
+    std::vector<std::int32_t> denseLiouville (root + 1, 0);
+    std::vector<std::int64_t> sparseMertens (sparseEnd - bigCount, 0);
+    std::vector<std::int64_t> sparseLiouville (sparseEnd - bigCount, 0);
+
+    // Returns the index in the sparse tables of 'k', in ('bigCount', 'sparseEnd'].
+    auto sparseIndex = [bigCount] (std::uint64_t k) { return k - bigCount - 1; };
+
+    std::vector<std::uint64_t> basePrimes = *PrimeSieve<std::uint64_t> (IntegerSqrt (sieveLimit) + 1).Primes ();
+
+    // Each thread sieves a contiguous run of segments of [1, 'sieveLimit'], recording sums local to its run,
+    // to which the totals of the preceding runs are added once every thread has finished.
+    std::uint64_t segmentCount = (sieveLimit + segmentSize - 1) / segmentSize;
+    threadCount = std::max (std::size_t (1), std::min (threadCount, std::size_t (segmentCount)));
+    std::vector<SummatoryValues> threadSums (threadCount, { 0, 0 });
+
+    auto runStart = [&] (std::size_t thread) { return 1 + segmentCount * thread / threadCount * segmentSize; };
+    auto runEnd = [&] (std::size_t thread)
+    {
+        return std::min (sieveLimit + 1, 1 + segmentCount * (thread + 1) / threadCount * segmentSize);
+    };
+
+    auto sieveRun = [&] (std::size_t thread)
+    {
+        std::vector<std::uint64_t> products (segmentSize);
+        std::vector<std::int8_t> mu (segmentSize);
+        std::vector<std::int8_t> lambda (segmentSize);
+        SummatoryValues sums { 0, 0 };
+
+        for (std::uint64_t segmentStart = runStart (thread); segmentStart < runEnd (thread); segmentStart += segmentSize)
+        {
+            std::uint64_t segmentEnd = std::min (runEnd (thread), segmentStart + segmentSize);
+            SieveSegment (segmentStart, segmentEnd, basePrimes, products, mu, lambda);
+
+            // The sparse arguments in the segment, in increasing order, are 'n' / 'k' for 'k' descending from
+            // 'k' = 'n' / 'segmentStart'.
+            std::uint64_t k = std::min (sparseEnd, n / segmentStart);
+            std::uint64_t nextSparse = k > bigCount ? n / k : 0;
+
+            for (std::uint64_t m = segmentStart; m < segmentEnd; ++m)
+            {
+                sums.mertens += mu[m - segmentStart];
+                sums.liouville += lambda[m - segmentStart];
+
+                if (m <= root)
+                {
+                    denseMertens[m] = std::int32_t (sums.mertens);
+                    denseLiouville[m] = std::int32_t (sums.liouville);
+                }
+
+                while (m == nextSparse)
+                {
+                    sparseMertens[sparseIndex (k)] = sums.mertens;
+                    sparseLiouville[sparseIndex (k)] = sums.liouville;
+                    --k;
+                    nextSparse = k > bigCount ? n / k : 0;
+                }
+            }
+        }
+
+        threadSums[thread] = sums;
+    };
+
+    std::vector<std::thread> threads;
+
+    for (std::size_t thread = 1; thread < threadCount; ++thread)
+        threads.emplace_back (sieveRun, thread);
+
+    sieveRun (0);
+
+    for (std::thread& thread : threads)
+        thread.join ();
+
+    // Add to each recorded sum the totals of the runs preceding its own.
+    SummatoryValues offset { 0, 0 };
+
+    for (std::size_t thread = 0; thread < threadCount; ++thread)
+    {
+        if (thread > 0)
+        {
+            std::uint64_t start = runStart (thread);
+            std::uint64_t end = runEnd (thread);
+
+            for (std::uint64_t m = start; m < end && m <= root; ++m)
+            {
+                denseMertens[m] += std::int32_t (offset.mertens);
+                denseLiouville[m] += std::int32_t (offset.liouville);
+            }
+
+            for (std::uint64_t k = std::min (sparseEnd, n / start); k > bigCount && n / k < end; --k)
+            {
+                sparseMertens[sparseIndex (k)] += offset.mertens;
+                sparseLiouville[sparseIndex (k)] += offset.liouville;
+            }
+        }
+
+        offset.mertens += threadSums[thread].mertens;
+        offset.liouville += threadSums[thread].liouville;
+    }
+
+    // Evaluate the recursion for 'n' / 'i', largest 'i' first. Its terms are at 'n' / ('i' * 'd') for 'd' up to
+    // the square root of 'n' / 'i', then dense values weighted by the number of 'd' sharing each quotient.
+    // The arguments for 'i' in ('bigCount' / 2, 'bigCount'] depend only on sieved values, those for 'i' in
+    // ('bigCount' / 4, 'bigCount' / 2] only on those and sieved values, and so on, so each such band is shared
+    // between the threads.
+    std::vector<SummatoryValues> big (bigCount + 1, { 0, 0 });
+
+    auto evaluate = [&] (std::uint64_t i)
+    {
+        std::uint64_t v = n / i;
+        std::uint64_t squareRoot = IntegerSqrt (v);
+        SummatoryValues sum { 0, 0 };
+
+        for (std::uint64_t d = 2; d <= squareRoot; ++d)
+        {
+            std::uint64_t k = i * d;
+
+            if (k <= bigCount)
+            {
+                sum.mertens += big[k].mertens;
+                sum.liouville += big[k].liouville;
+            }
+            else if (k <= sparseEnd)
+            {
+                sum.mertens += sparseMertens[sparseIndex (k)];
+                sum.liouville += sparseLiouville[sparseIndex (k)];
+            }
+            else
+            {
+                sum.mertens += denseMertens[v / d];
+                sum.liouville += denseLiouville[v / d];
+            }
+        }
+
+        for (std::uint64_t q = 1, qEnd = v / (squareRoot + 1); q <= qEnd; ++q)
+        {
+            std::int64_t count = v / q - std::max (v / (q + 1), squareRoot);
+            sum.mertens += count * denseMertens[q];
+            sum.liouville += count * denseLiouville[q];
+        }
+
+        big[i] = { 1 - sum.mertens, std::int64_t (squareRoot) - sum.liouville };
+    };
+
+    for (std::uint64_t bandEnd = bigCount; bandEnd > 0; bandEnd /= 2)
+    {
+        std::uint64_t bandStart = bandEnd / 2 + 1;
+        std::atomic<std::uint64_t> next (bandStart);
+
+        auto evaluateBand = [&] ()
+        {
+            for (std::uint64_t i = next++; i <= bandEnd; i = next++)
+                evaluate (i);
+        };
+
+        std::size_t bandThreadCount = std::min (threadCount, std::size_t (bandEnd - bandStart + 1));
+        threads.clear ();
+
+        for (std::size_t thread = 1; thread < bandThreadCount; ++thread)
+            threads.emplace_back (evaluateBand);
+
+        evaluateBand ();
+
+        for (std::thread& thread : threads)
+            thread.join ();
+    }
+
+    return big[1];
+}
+
+// Returns the summatory functions of 'n', from the cache if they have been computed before.
+static SummatoryValues Summatory (std::uint64_t n, std::size_t threadCount)
+{
+    static std::map<std::uint64_t, SummatoryValues> cache;
+    static std::mutex cacheMutex;
+
+    {
+        std::lock_guard<std::mutex> lock (cacheMutex);
+        auto cached = cache.find (n);
+
+        if (cached != cache.end ())
+            return cached->second;
+    }
+
+    SummatoryValues sums = n < directLimit ? SumDirectly (n) : SumByHyperbola (n, threadCount);
+
+    std::lock_guard<std::mutex> lock (cacheMutex);
+    cache.emplace (n, sums);
+    return sums;
+}
+
+std::int64_t Mertens (std::uint64_t n, std::size_t threadCount)
+{
+    return Summatory (n, threadCount).mertens;
+}
+
+std::int64_t SummatoryLiouville (std::uint64_t n, std::size_t threadCount)
+{
+    return Summatory (n, threadCount).liouville;
+}
@@ -0,0 +1,14 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Returns the Mertens function of 'n', the sum of the Moebius function over [1, 'n'], using up to 'threadCount'
+// threads.
+// Only a segmented sieve up to about 'n' to the power 2/3 is run, so 'n' may range far beyond what a table can hold.
+// Results are cached, and each computation yields both this and 'SummatoryLiouville' of the same 'n'.
+std::int64_t Mertens (std::uint64_t n, std::size_t threadCount = 1);
+
+// Returns the summatory Liouville function of 'n', the sum of the Liouville function over [1, 'n'], using up to
+// 'threadCount' threads, computed and cached alongside 'Mertens'.
+std::int64_t SummatoryLiouville (std::uint64_t n, std::size_t threadCount = 1);